@@ -0,0 +1,107 @@
+#include "ae483_batchlog.h"
+
+#include <string.h>
+
+#include "app_channel.h"
+
+// App-channel payload size: CRTP data (30 bytes) minus the app-channel
+// header byte, minus our one-byte fragment sequence number
+#define FRAGMENT_PAYLOAD 28
+
+// Ring of packed records, treated as a byte stream by the pump. 256 records
+// (~27 KB) absorbs about half a second of full-rate capture while the radio
+// drains; sized to fit comfortably in CCM alongside the rest of the build.
+#define RING_RECORDS 256
+
+static ae483BatchlogRecord_t ring[RING_RECORDS];
+static uint32_t ring_head = 0;  // records produced
+static uint32_t ring_tail = 0;  // records fully sent
+static uint32_t send_offset = 0; // bytes of the tail record already sent
+static uint32_t dropped = 0;
+static uint8_t seq = 0;
+
+typedef struct __attribute__((packed)) {
+  uint8_t seq;
+  uint8_t data[FRAGMENT_PAYLOAD];
+} fragment_t;
+
+void ae483BatchlogInit(void)
+{
+  ring_head = 0;
+  ring_tail = 0;
+  send_offset = 0;
+  dropped = 0;
+  seq = 0;
+}
+
+void ae483BatchlogPush(const ae483BatchlogRecord_t *rec)
+{
+  if (ring_head - ring_tail >= RING_RECORDS) {
+    // Radio is not keeping up: drop the oldest record whose transmission
+    // has not begun instead of blocking the 500 Hz tick (the decoder
+    // resyncs on the magic word). If the tail record is mid-flight its
+    // remaining bytes must still go out — cutting it would leave its
+    // prefix (a valid magic) spliced onto the next record's bytes, which
+    // the decoder would misparse as one garbage record — so the drop
+    // victim is its successor: the tail record is moved over it and
+    // send_offset keeps indexing into the moved copy.
+    if (send_offset > 0) {
+      ring[(ring_tail + 1) % RING_RECORDS] = ring[ring_tail % RING_RECORDS];
+    }
+    ring_tail++;
+    dropped++;
+  }
+  ring[ring_head % RING_RECORDS] = *rec;
+  ring[ring_head % RING_RECORDS].magic = AE483_BATCHLOG_MAGIC;
+  ring_head++;
+}
+
+void ae483BatchlogPump(int max_packets)
+{
+  fragment_t frag;
+
+  for (int p = 0; p < max_packets; p++) {
+    if (ring_tail == ring_head) {
+      return;
+    }
+
+    // Fill one fragment from the byte stream formed by the queued records
+    int filled = 0;
+    while (filled < FRAGMENT_PAYLOAD && ring_tail != ring_head) {
+      const uint8_t *rec = (const uint8_t *)&ring[ring_tail % RING_RECORDS];
+      int remaining = (int)sizeof(ae483BatchlogRecord_t) - (int)send_offset;
+      int chunk = remaining < (FRAGMENT_PAYLOAD - filled) ? remaining
+                                                          : (FRAGMENT_PAYLOAD - filled);
+      memcpy(&frag.data[filled], rec + send_offset, chunk);
+      filled += chunk;
+      send_offset += chunk;
+      if (send_offset >= sizeof(ae483BatchlogRecord_t)) {
+        ring_tail++;
+        send_offset = 0;
+      }
+    }
+
+    frag.seq = seq;
+    if (appchannelSendDataPacket(&frag, 1 + filled) != 0) {
+      // Queue full; try again next tick without consuming the data we
+      // could not send
+      // (roll back the bytes copied into this fragment)
+      while (filled > 0) {
+        if (send_offset == 0) {
+          ring_tail--;
+          send_offset = sizeof(ae483BatchlogRecord_t);
+        }
+        int chunk = filled < (int)send_offset ? filled : (int)send_offset;
+        send_offset -= chunk;
+        filled -= chunk;
+      }
+      return;
+    }
+    seq++;
+  }
+}
+
+uint32_t ae483BatchlogDropped(void)
+{
+  return dropped;
+}
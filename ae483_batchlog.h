@@ -0,0 +1,46 @@
+#ifndef __AE483_BATCHLOG_H__
+#define __AE483_BATCHLOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ae483_state.h"
+
+// Packed binary flight logging for the AE483 controller.
+//
+// The ae483log group has ~30 variables; streamed individually over CRTP log
+// blocks at 100 Hz they saturate the radio and force channels to be
+// dropped. This module instead snapshots the full controller state into one
+// fixed-stride packed record per tick, buffers records in a RAM ring, and
+// streams the ring as a dense byte stream over the CRTP app channel (one
+// sequence-numbered fragment per packet). ae483_binlog.py on the host
+// reassembles the stream and emits the same JSON schema that
+// flight_plane.py's SimpleClient writes, so ProjectDataAnalysis.ipynb needs
+// no changes.
+//
+// Each record starts with a magic word so the decoder can resync after a
+// lost packet.
+
+#define AE483_BATCHLOG_MAGIC 0x48AE
+
+typedef struct __attribute__((packed)) {
+  uint16_t magic;       // AE483_BATCHLOG_MAGIC
+  uint32_t tick;
+  ae483State_t state;   // snapshot of the shared controller state
+} ae483BatchlogRecord_t;
+
+void ae483BatchlogInit(void);
+
+// Producer (the 500 Hz controller tick): queue one record. If the radio
+// cannot keep up the oldest unsent records are dropped and counted rather
+// than blocking the tick.
+void ae483BatchlogPush(const ae483BatchlogRecord_t *rec);
+
+// Drain: send up to max_packets app-channel fragments of the byte stream.
+// Called from the controller tick; never blocks.
+void ae483BatchlogPump(int max_packets);
+
+// Records dropped because the ring was full (exposed via ae483log)
+uint32_t ae483BatchlogDropped(void);
+
+#endif // __AE483_BATCHLOG_H__
@@ -0,0 +1,98 @@
+"""
+Decoder for the packed binary flight log streamed by ae483_batchlog.c.
+
+The firmware snapshots the full controller state into one fixed-stride
+packed record per tick and streams the records as a sequence-numbered byte
+stream over the CRTP app channel. This module reassembles that stream and
+emits the same JSON schema that flight_plane.py's SimpleClient writes, so
+ProjectDataAnalysis.ipynb can read either kind of flight file.
+
+Usage with cflib:
+
+    decoder = BinlogDecoder()
+    cf.appchannel.packet_received.add_callback(decoder.feed)
+    ...fly...
+    decoder.write_data('hardware_data.json')
+"""
+
+import json
+import struct
+
+MAGIC = 0x48AE
+
+# Must match ae483BatchlogRecord_t in ae483_batchlog.h (magic, tick, then
+# ae483State_t)
+RECORD_STRUCT = struct.Struct('<HI23f4H')
+RECORD_SIZE = RECORD_STRUCT.size
+
+# Must match the field order of ae483State_t in ae483_state.h
+FIELDS = [
+    'o_x', 'o_y', 'o_z',
+    'psi', 'theta', 'phi',
+    'v_x', 'v_y', 'v_z',
+    'w_x', 'w_y', 'w_z',
+    'n_x', 'n_y', 'r', 'a_z',
+    'o_x_des', 'o_y_des', 'o_z_des',
+    'tau_x', 'tau_y', 'tau_z', 'f_z',
+    'm_1', 'm_2', 'm_3', 'm_4',
+]
+
+
+class BinlogDecoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_seq = None
+        self.num_lost_packets = 0
+        self.data = {f'ae483log.{name}': {'time': [], 'data': []}
+                     for name in FIELDS}
+
+    def feed(self, packet):
+        """Consume one app-channel packet (bytes: [seq][fragment])."""
+        if len(packet) < 2:
+            return
+        seq = packet[0]
+        if self.last_seq is not None and seq != (self.last_seq + 1) % 256:
+            # Lost packet(s): drop any partial record and resync on the
+            # next magic word
+            self.num_lost_packets += 1
+            self.buffer.clear()
+        self.last_seq = seq
+        self.buffer.extend(packet[1:])
+        self._extract_records()
+
+    def _extract_records(self):
+        while len(self.buffer) >= RECORD_SIZE:
+            if self.buffer[0] | (self.buffer[1] << 8) != MAGIC:
+                # Not aligned on a record: scan forward to the next magic
+                idx = self.buffer.find(MAGIC.to_bytes(2, 'little'), 1)
+                if idx < 0:
+                    self.buffer = self.buffer[-1:]
+                    return
+                del self.buffer[:idx]
+                continue
+            values = RECORD_STRUCT.unpack_from(self.buffer)
+            del self.buffer[:RECORD_SIZE]
+            tick = values[1]
+            for name, value in zip(FIELDS, values[2:]):
+                entry = self.data[f'ae483log.{name}']
+                entry['time'].append(tick)  # tick increments at 1 kHz == ms
+                entry['data'].append(value)
+
+    def write_data(self, filename='logged_data.json'):
+        """Write the reassembled log in the SimpleClient JSON schema."""
+        with open(filename, 'w') as outfile:
+            json.dump(self.data, outfile, indent=4, sort_keys=False)
+
+
+def decode_file(filename):
+    """Decode a raw dump of app-channel packets (one length-prefixed packet
+    per record, as written by a simple capture script) into the SimpleClient
+    data dict."""
+    decoder = BinlogDecoder()
+    with open(filename, 'rb') as f:
+        while True:
+            header = f.read(1)
+            if not header:
+                break
+            decoder.feed(f.read(header[0]))
+    return decoder.data
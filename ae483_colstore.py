@@ -0,0 +1,163 @@
+"""
+Memory-mapped columnar store for flight logs.
+
+ProjectDataAnalysis.ipynb re-parses multi-megabyte FlightTestData .json
+files on every kernel restart, and every channel becomes a Python list.
+This module stores a flight as one contiguous float32 array per logged
+channel (plus a float64 timestamp array each), with a small binary index
+header in front, and loads it by mmap: opening a flight is O(header) and
+reading a channel is a zero-copy memoryview into the file, so loading all
+flights for a report drops from minutes to milliseconds and costs no
+resident RAM beyond the pages actually touched.
+
+Convert once, then load everywhere — the notebook and the SIL tooling
+(sil/prepare_replay.py accepts .col files directly) share this loader:
+
+    python ae483_colstore.py convert flight.json          # -> flight.col
+    python ae483_colstore.py info flight.col
+
+    from ae483_colstore import ColStore
+    store = ColStore('flight.col')
+    o_z = store.data('ae483log.o_z')     # memoryview of float32
+    t = store.time('ae483log.o_z')       # memoryview of float64, ms
+
+File layout (little-endian): magic 'AE483COL', version u32, channel count
+u32, then one index entry per channel (name length u16, name utf-8, sample
+count u64, time offset u64, data offset u64), then the arrays, 8-byte
+aligned. Pure standard library (mmap + memoryview.cast), no numpy needed —
+though numpy users get zero-copy arrays with np.frombuffer(store.data(n)).
+"""
+
+import json
+import mmap
+import struct
+import sys
+from array import array
+from pathlib import Path
+
+MAGIC = b'AE483COL'
+VERSION = 1
+
+
+def _pad8(n):
+    return (n + 7) & ~7
+
+
+def write_col(data, path):
+    """Write a SimpleClient-schema data dict ({channel: {'time': [...],
+    'data': [...]}}) as a columnar file."""
+    names = sorted(data.keys())
+
+    # Index layout first, so array offsets are known before writing
+    header_size = len(MAGIC) + 8  # magic + version + count
+    for name in names:
+        header_size += 2 + len(name.encode()) + 24
+    offset = _pad8(header_size)
+
+    entries = []
+    for name in names:
+        count = len(data[name]['data'])
+        time_off = offset
+        offset = _pad8(offset + 8 * count)
+        data_off = offset
+        offset = _pad8(offset + 4 * count)
+        entries.append((name, count, time_off, data_off))
+
+    with open(path, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('<II', VERSION, len(names)))
+        for name, count, time_off, data_off in entries:
+            encoded = name.encode()
+            f.write(struct.pack('<H', len(encoded)))
+            f.write(encoded)
+            f.write(struct.pack('<QQQ', count, time_off, data_off))
+        for name, count, time_off, data_off in entries:
+            f.write(b'\0' * (time_off - f.tell()))
+            array('d', (float(t) for t in data[name]['time'])).tofile(f)
+            f.write(b'\0' * (data_off - f.tell()))
+            array('f', (float(v) for v in data[name]['data'])).tofile(f)
+        f.write(b'\0' * (offset - f.tell()))
+
+
+class ColStore:
+    """Zero-copy reader: channels are memoryviews into the mmap."""
+
+    def __init__(self, path):
+        self._file = open(path, 'rb')
+        self._mm = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        self._view = memoryview(self._mm)
+        if self._mm[:len(MAGIC)] != MAGIC:
+            raise ValueError(f'{path} is not an AE483 columnar log')
+        version, count = struct.unpack_from('<II', self._mm, len(MAGIC))
+        if version != VERSION:
+            raise ValueError(f'{path}: format version {version}, '
+                             f'expected {VERSION}')
+        self._index = {}
+        pos = len(MAGIC) + 8
+        for _ in range(count):
+            (name_len,) = struct.unpack_from('<H', self._mm, pos)
+            pos += 2
+            name = self._mm[pos:pos + name_len].decode()
+            pos += name_len
+            self._index[name] = struct.unpack_from('<QQQ', self._mm, pos)
+            pos += 24
+
+    @property
+    def channels(self):
+        return list(self._index)
+
+    def time(self, name):
+        count, time_off, _ = self._index[name]
+        return self._view[time_off:time_off + 8 * count].cast('d')
+
+    def data(self, name):
+        count, _, data_off = self._index[name]
+        return self._view[data_off:data_off + 4 * count].cast('f')
+
+    def as_dict(self):
+        """The SimpleClient data-dict shape, backed by the mmap: a drop-in
+        for json.load(flight_file) anywhere only indexing and iteration
+        are needed (e.g. sil/prepare_replay.py)."""
+        return {name: {'time': self.time(name), 'data': self.data(name)}
+                for name in self._index}
+
+    def close(self):
+        """Release the store. Channel views handed out by time()/data()/
+        as_dict() stay valid: they pin the mapping, so if any are still
+        alive the mmap cannot be closed here and is reclaimed when the
+        last view is garbage collected instead."""
+        self._view.release()
+        try:
+            self._mm.close()
+        except BufferError:
+            # exported channel views keep the mapping alive
+            pass
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def main():
+    if len(sys.argv) >= 3 and sys.argv[1] == 'convert':
+        src = Path(sys.argv[2])
+        dst = Path(sys.argv[3]) if len(sys.argv) > 3 \
+            else src.with_suffix('.col')
+        with open(src) as f:
+            data = json.load(f)
+        write_col(data, dst)
+        print(f'{src} -> {dst} ({len(data)} channels, '
+              f'{dst.stat().st_size} bytes)')
+    elif len(sys.argv) == 3 and sys.argv[1] == 'info':
+        with ColStore(sys.argv[2]) as store:
+            for name in store.channels:
+                print(f'{len(store.data(name)):>8}  {name}')
+    else:
+        raise SystemExit(__doc__)
+
+
+if __name__ == '__main__':
+    main()
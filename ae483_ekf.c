@@ -0,0 +1,248 @@
+#include "ae483_ekf.h"
+
+#include <math.h>
+
+#define N AE483_EKF_N
+
+// Constants
+static const float g = 9.81f;
+
+// Configuration
+static ae483EkfConfig_t cfg;
+
+// State estimate
+static float x[N];
+
+// Covariance and workspace, statically allocated row-major
+static float P[N*N];
+static float FP[N*N];   // F * P scratch for the predict step
+static float K[N];      // Kalman gain column for a scalar update
+static float PHt[N];    // P * H^T scratch for a scalar update
+
+void ae483EkfDefaultConfig(ae483EkfConfig_t *config)
+{
+  for (int i=0;i<N;i++) {
+    config->q_diag[i] = 0.1f;
+    config->p0_diag[i] = 1.0f;
+  }
+  config->r_flow_x = 0.7570370678653842f*0.7570370678653842f;
+  config->r_flow_y = 0.7698969611565406f*0.7698969611565406f;
+  config->r_tof = 0.06350709061837238f*0.06350709061837238f;
+  config->r_dist = 0.05f*0.05f;
+  config->r_pose_pos = 0.005f*0.005f;
+  config->r_pose_att = 0.02f*0.02f;
+  config->k_flow = 4.09255568f;
+  config->o_z_eq = 0.5f;
+  config->dt = 0.002f;
+}
+
+void ae483EkfReset(void)
+{
+  for (int i=0;i<N;i++) {
+    x[i] = 0.0f;
+  }
+  for (int i=0;i<N*N;i++) {
+    P[i] = 0.0f;
+  }
+  for (int i=0;i<N;i++) {
+    P[i*N+i] = cfg.p0_diag[i];
+  }
+}
+
+void ae483EkfInit(const ae483EkfConfig_t *config)
+{
+  cfg = *config;
+  ae483EkfReset();
+}
+
+void ae483EkfPredict(float w_x, float w_y, float w_z, float a_z)
+{
+  const float dt = cfg.dt;
+
+  // State propagation (same model as the LQR observer, without corrections)
+  x[AE483_EKF_O_X]   += dt * x[AE483_EKF_V_X];
+  x[AE483_EKF_O_Y]   += dt * x[AE483_EKF_V_Y];
+  x[AE483_EKF_O_Z]   += dt * x[AE483_EKF_V_Z];
+  x[AE483_EKF_PSI]   += dt * w_z;
+  x[AE483_EKF_THETA] += dt * w_y;
+  x[AE483_EKF_PHI]   += dt * w_x;
+  x[AE483_EKF_V_X]   += dt * g * x[AE483_EKF_THETA];
+  x[AE483_EKF_V_Y]   += dt * -g * x[AE483_EKF_PHI];
+  x[AE483_EKF_V_Z]   += dt * (a_z - g);
+
+  // Covariance propagation P = F P F^T + Q with F = I + dt*A, where A is
+  // sparse: A[0][6] = A[1][7] = A[2][8] = 1, A[6][4] = g, A[7][5] = -g.
+  // Apply the sparse structure directly instead of a dense 9x9 product.
+
+  // FP = F * P: row i of FP is row i of P plus dt*coeff times another row
+  for (int i=0;i<N*N;i++) {
+    FP[i] = P[i];
+  }
+  for (int j=0;j<N;j++) {
+    FP[AE483_EKF_O_X*N+j] += dt * P[AE483_EKF_V_X*N+j];
+    FP[AE483_EKF_O_Y*N+j] += dt * P[AE483_EKF_V_Y*N+j];
+    FP[AE483_EKF_O_Z*N+j] += dt * P[AE483_EKF_V_Z*N+j];
+    FP[AE483_EKF_V_X*N+j] += dt * g * P[AE483_EKF_THETA*N+j];
+    FP[AE483_EKF_V_Y*N+j] += dt * -g * P[AE483_EKF_PHI*N+j];
+  }
+
+  // P = FP * F^T: column j of P is column j of FP plus dt*coeff times
+  // another column, then add Q on the diagonal
+  for (int i=0;i<N*N;i++) {
+    P[i] = FP[i];
+  }
+  for (int i=0;i<N;i++) {
+    P[i*N+AE483_EKF_O_X] += dt * FP[i*N+AE483_EKF_V_X];
+    P[i*N+AE483_EKF_O_Y] += dt * FP[i*N+AE483_EKF_V_Y];
+    P[i*N+AE483_EKF_O_Z] += dt * FP[i*N+AE483_EKF_V_Z];
+    P[i*N+AE483_EKF_V_X] += dt * g * FP[i*N+AE483_EKF_THETA];
+    P[i*N+AE483_EKF_V_Y] += dt * -g * FP[i*N+AE483_EKF_PHI];
+  }
+  for (int i=0;i<N;i++) {
+    P[i*N+i] += cfg.q_diag[i];
+  }
+}
+
+// Scalar measurement update in Joseph form:
+//   S = H P H^T + R
+//   K = P H^T / S
+//   x += K * innovation
+//   P = (I - K H) P (I - K H)^T + K R K^T
+// H has a single nonzero entry h at state index idx, which keeps the update
+// a rank-1 operation with a bounded cycle count.
+static void scalarUpdate(int idx, float h, float innovation, float R)
+{
+  for (int i=0;i<N;i++) {
+    PHt[i] = P[i*N+idx] * h;
+  }
+  float S = h * P[idx*N+idx] * h + R;
+  float S_inv = 1.0f / S;
+  for (int i=0;i<N;i++) {
+    K[i] = PHt[i] * S_inv;
+  }
+
+  for (int i=0;i<N;i++) {
+    x[i] += K[i] * innovation;
+  }
+
+  // Joseph form, expanded for scalar H:
+  //   P = P - K (H P) - (P H^T) K^T + K S K^T
+  // H P must be the prior row idx of P, which the i == idx pass below
+  // overwrites — use the PHt scratch (h*P[idx][j] by symmetry), which
+  // caches it
+  for (int i=0;i<N;i++) {
+    for (int j=0;j<N;j++) {
+      P[i*N+j] += -K[i]*PHt[j] - PHt[i]*K[j] + K[i]*S*K[j];
+    }
+  }
+
+  // Keep the covariance symmetric against roundoff
+  for (int i=0;i<N;i++) {
+    for (int j=i+1;j<N;j++) {
+      float p = 0.5f * (P[i*N+j] + P[j*N+i]);
+      P[i*N+j] = p;
+      P[j*N+i] = p;
+    }
+  }
+}
+
+// Same Joseph-form update for a measurement row h with several nonzero
+// entries (scalarUpdate stays as the optimized single-entry case; the gain
+// is still one column, so the cycle count is the same order). P is kept
+// symmetric, so H P falls out of the P H^T scratch for free.
+static void rowUpdate(const float *h, float innovation, float R)
+{
+  for (int i=0;i<N;i++) {
+    float acc = 0.0f;
+    for (int j=0;j<N;j++) {
+      acc += P[i*N+j] * h[j];
+    }
+    PHt[i] = acc;
+  }
+  float S = R;
+  for (int i=0;i<N;i++) {
+    S += h[i] * PHt[i];
+  }
+  float S_inv = 1.0f / S;
+  for (int i=0;i<N;i++) {
+    K[i] = PHt[i] * S_inv;
+  }
+
+  for (int i=0;i<N;i++) {
+    x[i] += K[i] * innovation;
+  }
+
+  for (int i=0;i<N;i++) {
+    for (int j=0;j<N;j++) {
+      P[i*N+j] += -K[i]*PHt[j] - PHt[i]*K[j] + K[i]*S*K[j];
+    }
+  }
+
+  for (int i=0;i<N;i++) {
+    for (int j=i+1;j<N;j++) {
+      float p = 0.5f * (P[i*N+j] + P[j*N+i]);
+      P[i*N+j] = p;
+      P[j*N+i] = p;
+    }
+  }
+}
+
+void ae483EkfCorrectFlowX(float n_x, float w_y)
+{
+  // n_x = k_flow * (v_x / o_z_eq - w_y)
+  float h = cfg.k_flow / cfg.o_z_eq;
+  float predicted = cfg.k_flow * ((x[AE483_EKF_V_X] / cfg.o_z_eq) - w_y);
+  scalarUpdate(AE483_EKF_V_X, h, n_x - predicted, cfg.r_flow_x);
+}
+
+void ae483EkfCorrectFlowY(float n_y, float w_x)
+{
+  // n_y = k_flow * (w_x + v_y / o_z_eq)
+  float h = cfg.k_flow / cfg.o_z_eq;
+  float predicted = cfg.k_flow * (w_x + (x[AE483_EKF_V_Y] / cfg.o_z_eq));
+  scalarUpdate(AE483_EKF_V_Y, h, n_y - predicted, cfg.r_flow_y);
+}
+
+void ae483EkfCorrectTOF(float r)
+{
+  // r = o_z
+  scalarUpdate(AE483_EKF_O_Z, 1.0f, r - x[AE483_EKF_O_Z], cfg.r_tof);
+}
+
+void ae483EkfCorrectDistance(float a_x, float a_y, float a_z, float d)
+{
+  // d = |p - a|, linearized at the current estimate: the measurement row
+  // is the unit ray from the anchor to the vehicle at the position states
+  float dx = x[AE483_EKF_O_X] - a_x;
+  float dy = x[AE483_EKF_O_Y] - a_y;
+  float dz = x[AE483_EKF_O_Z] - a_z;
+  float d_pred = sqrtf(dx*dx + dy*dy + dz*dz);
+  if (d_pred < 1e-3f) {
+    // Degenerate geometry (estimate on top of the anchor): no ray to
+    // correct along
+    return;
+  }
+  float h[N] = {0.0f};
+  h[AE483_EKF_O_X] = dx / d_pred;
+  h[AE483_EKF_O_Y] = dy / d_pred;
+  h[AE483_EKF_O_Z] = dz / d_pred;
+  rowUpdate(h, d - d_pred, cfg.r_dist);
+}
+
+void ae483EkfCorrectPose(float o_x, float o_y, float o_z,
+                         float psi, float theta, float phi)
+{
+  // Six direct measurements, H = 1 at each state: six rank-1 updates,
+  // still a bounded cycle count
+  scalarUpdate(AE483_EKF_O_X,   1.0f, o_x   - x[AE483_EKF_O_X],   cfg.r_pose_pos);
+  scalarUpdate(AE483_EKF_O_Y,   1.0f, o_y   - x[AE483_EKF_O_Y],   cfg.r_pose_pos);
+  scalarUpdate(AE483_EKF_O_Z,   1.0f, o_z   - x[AE483_EKF_O_Z],   cfg.r_pose_pos);
+  scalarUpdate(AE483_EKF_PSI,   1.0f, psi   - x[AE483_EKF_PSI],   cfg.r_pose_att);
+  scalarUpdate(AE483_EKF_THETA, 1.0f, theta - x[AE483_EKF_THETA], cfg.r_pose_att);
+  scalarUpdate(AE483_EKF_PHI,   1.0f, phi   - x[AE483_EKF_PHI],   cfg.r_pose_att);
+}
+
+const float* ae483EkfState(void)
+{
+  return x;
+}
@@ -0,0 +1,81 @@
+#ifndef __AE483_EKF_H__
+#define __AE483_EKF_H__
+
+#include <stdbool.h>
+
+// Fixed-size 9-state EKF / LQE engine for the AE483 observer.
+//
+// State vector (in order):
+//   o_x, o_y, o_z, psi, theta, phi, v_x, v_y, v_z
+//
+// Unlike the three independent scalar filters in controller_ae483_custom_k.c,
+// this engine carries the full 9x9 covariance, so cross-covariance between
+// o_z, v_x, v_y and theta/phi is fused in a single pass per measurement and
+// no over-iteration is needed. The LQR observer in controller_custom_lqr.c
+// is one configuration of this engine (fixed gains, no covariance update).
+//
+// All storage is statically allocated row-major float; there is no heap use
+// and the cycle count per call is bounded (one sparse 9x9 covariance
+// propagation per predict, one Joseph-form rank-1 update per scalar
+// measurement).
+
+#define AE483_EKF_N 9
+
+// Indices into the state vector
+#define AE483_EKF_O_X   0
+#define AE483_EKF_O_Y   1
+#define AE483_EKF_O_Z   2
+#define AE483_EKF_PSI   3
+#define AE483_EKF_THETA 4
+#define AE483_EKF_PHI   5
+#define AE483_EKF_V_X   6
+#define AE483_EKF_V_Y   7
+#define AE483_EKF_V_Z   8
+
+typedef struct {
+  float q_diag[AE483_EKF_N]; // process noise (diagonal)
+  float r_flow_x;            // flow n_x measurement noise
+  float r_flow_y;            // flow n_y measurement noise
+  float r_tof;               // tof r measurement noise
+  float r_dist;              // anchor distance measurement noise (loco deck)
+  float r_pose_pos;          // mocap pose position measurement noise
+  float r_pose_att;          // mocap pose attitude measurement noise
+  float p0_diag[AE483_EKF_N]; // initial covariance (diagonal)
+  float k_flow;              // flow model constant
+  float o_z_eq;              // equilibrium height used in the flow model
+  float dt;                  // predict step, seconds
+} ae483EkfConfig_t;
+
+// Fill config with the tuning used on the final flight tests
+void ae483EkfDefaultConfig(ae483EkfConfig_t *config);
+
+// Set config and reset state and covariance
+void ae483EkfInit(const ae483EkfConfig_t *config);
+
+// Zero the state and reset covariance to p0_diag
+void ae483EkfReset(void);
+
+// Propagate state and covariance one dt using gyro rates and z acceleration
+void ae483EkfPredict(float w_x, float w_y, float w_z, float a_z);
+
+// Scalar measurement updates (Joseph form, safe to call at measurement rate)
+void ae483EkfCorrectFlowX(float n_x, float w_y);
+void ae483EkfCorrectFlowY(float n_y, float w_x);
+void ae483EkfCorrectTOF(float r);
+
+// Anchor distance update: d is the measured range to an anchor at
+// (a_x, a_y, a_z). The range model is linearized at the current estimate,
+// so H has three nonzero entries (the unit ray to the anchor) at the
+// position states; still one rank-1 update per measurement.
+void ae483EkfCorrectDistance(float a_x, float a_y, float a_z, float d);
+
+// Full pose update (mocap): six direct scalar measurements, one per
+// position and attitude state. The caller is responsible for latency
+// compensation and for unwrapping psi near the current estimate.
+void ae483EkfCorrectPose(float o_x, float o_y, float o_z,
+                         float psi, float theta, float phi);
+
+// Read access to the state vector (length AE483_EKF_N)
+const float* ae483EkfState(void);
+
+#endif // __AE483_EKF_H__
@@ -0,0 +1,40 @@
+#ifndef __AE483_FIXQ_H__
+#define __AE483_FIXQ_H__
+
+#include <stdint.h>
+
+// Q16.16 fixed-point helpers for the observer hot path.
+//
+// Built with -DAE483_OBSERVER_FIXEDPOINT, the scalar observer kernel in
+// controller_ae483_custom_k.c runs on these instead of float32, which
+// keeps the FPU out of the estimator interrupt path (no lazy FPU context
+// save on preemption) and bounds worst-case tick latency to the integer
+// pipeline.
+//
+// Q16.16 suits the state ranges: positions are a few meters, velocities a
+// few m/s, and the flow/tof measurements and gains are all well inside
+// +/-32768, while the 2^-16 resolution (~15 um, ~15 um/s) is far below
+// sensor noise. Products go through int64 so intermediate overflow is not
+// a concern at these magnitudes.
+
+typedef int32_t q16_t;
+
+#define Q16_SHIFT 16
+#define Q16_ONE (1 << Q16_SHIFT)
+
+static inline q16_t q16FromFloat(float x)
+{
+  return (q16_t)(x * (float)Q16_ONE);
+}
+
+static inline float q16ToFloat(q16_t x)
+{
+  return (float)x * (1.0f / (float)Q16_ONE);
+}
+
+static inline q16_t q16Mul(q16_t a, q16_t b)
+{
+  return (q16_t)(((int64_t)a * b) >> Q16_SHIFT);
+}
+
+#endif // __AE483_FIXQ_H__
@@ -0,0 +1,44 @@
+#ifndef __AE483_GAINS_H__
+#define __AE483_GAINS_H__
+
+// Generated by generate_gains.py -- DO NOT EDIT BY HAND.
+// Edit the K / MIXER matrices in generate_gains.py and re-run it instead.
+//
+// Error/state vector, in order (last entry is the homogeneous 1 that
+// carries the equilibrium thrust bias):
+//   [o_x_err, o_y_err, o_z_err, psi, theta, phi, v_x, v_y, v_z, w_x, w_y, w_z, one]
+
+#define AE483_GAIN_NX 13
+
+// Mixer thrust gain (PWM per newton of f_z): the common-mode part of every
+// motor command, used by the saturation-aware mixer to separate thrust
+// from torque
+#define AE483_MIXER_FZ_GAIN 122328.6f
+
+// Controller gains: rows tau_x, tau_y, tau_z, f_z (u = K x)
+static const float AE483_K[4][AE483_GAIN_NX] = {
+  {0.0f, 0.0023943f, 0.0f, 0.0f, 0.0f, -0.00346463f, 0.0f, 0.00135445f, 0.0f, -0.00047651f, 0.0f, 0.0f, 0.0f},
+  {-0.00223966f, 0.0f, 0.0f, 0.0f, -0.00734151f, 0.0f, -0.00186963f, 0.0f, 0.0f, 0.0f, -0.00129356f, 0.0f, 0.0f},
+  {0.0f, 0.0f, 0.0f, -0.0016421f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.00039822f, 0.0f},
+  {0.0f, 0.0f, -0.11471886f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.09147906f, 0.0f, 0.0f, 0.0f, 0.352179f},
+};
+
+// Precomposed controller+mixer (MIXER K): motor PWM = AE483_PK x
+static const float AE483_PK[4][AE483_GAIN_NX] = {
+  {8302.256797f, -8875.496034f, -14033.39754f, 62759.38985f, 27214.44384f, 12843.13153f, 6930.582488f, -5020.847681f, -11190.50534f, 1766.387928f, 4795.132878f, 15219.56289f, 43081.56402f},
+  {-8302.256797f, -8875.496034f, -14033.39754f, -62759.38985f, -27214.44384f, 12843.13153f, -6930.582488f, -5020.847681f, -11190.50534f, 1766.387928f, -4795.132878f, -15219.56289f, 43081.56402f},
+  {-8302.256797f, 8875.496034f, -14033.39754f, 62759.38985f, -27214.44384f, -12843.13153f, -6930.582488f, 5020.847681f, -11190.50534f, -1766.387928f, -4795.132878f, 15219.56289f, 43081.56402f},
+  {8302.256797f, 8875.496034f, -14033.39754f, -62759.38985f, 27214.44384f, -12843.13153f, 6930.582488f, 5020.847681f, -11190.50534f, -1766.387928f, 4795.132878f, -15219.56289f, 43081.56402f},
+};
+
+static inline float ae483GainDot(const float row[AE483_GAIN_NX],
+                                 const float x[AE483_GAIN_NX])
+{
+  float sum = 0.0f;
+  for (int i = 0; i < AE483_GAIN_NX; i++) {
+    sum += row[i] * x[i];
+  }
+  return sum;
+}
+
+#endif // __AE483_GAINS_H__
@@ -0,0 +1,37 @@
+#include "ae483_lightdeck.h"
+
+static uint8_t last_duty = 0;
+
+__attribute__((weak)) void ae483LightDeckWrite(uint8_t duty)
+{
+  // No deck driver linked (SIL build, or deck absent)
+  (void)duty;
+}
+
+void ae483LightInit(void)
+{
+  last_duty = 0;
+  ae483LightDeckWrite(0);
+}
+
+void ae483LightSet(float intensity)
+{
+  if (intensity < 0.0f) {
+    intensity = 0.0f;
+  }
+  if (intensity > 1.0f) {
+    intensity = 1.0f;
+  }
+  // Square law: LED radiance is roughly linear in duty, but film response
+  // to it is not; squaring is a gamma of 2.0 for one multiply
+  uint8_t duty = (uint8_t)(intensity * intensity * 255.0f + 0.5f);
+  if (duty != last_duty) {
+    last_duty = duty;
+    ae483LightDeckWrite(duty);
+  }
+}
+
+uint8_t ae483LightDuty(void)
+{
+  return last_duty;
+}
@@ -0,0 +1,27 @@
+#ifndef __AE483_LIGHTDECK_H__
+#define __AE483_LIGHTDECK_H__
+
+#include <stdint.h>
+
+// Driver shim for the custom light deck (the painting LED from the lab
+// builds). Intensity commands come from the trajectory's light channel
+// inside controllerAE483(), so stroke on/off edges are phase-locked to the
+// position setpoint — both come from the same evaluator sample — instead
+// of arriving over the radio with tens of milliseconds of jitter.
+//
+// ae483LightSet() maps intensity 0..1 through a square law (cheap gamma)
+// to an 8-bit PWM duty and skips redundant hardware writes. The hardware
+// write itself, ae483LightDeckWrite(), is a weak no-op here: the deck
+// driver in the firmware tree overrides it with the timer-compare write
+// for the deck's PWM pin, and the SIL build links the no-op.
+
+void ae483LightInit(void);
+void ae483LightSet(float intensity);
+
+// Current commanded duty, for logging
+uint8_t ae483LightDuty(void);
+
+// Hardware hook, overridden by the deck driver
+void ae483LightDeckWrite(uint8_t duty);
+
+#endif // __AE483_LIGHTDECK_H__
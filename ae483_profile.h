@@ -0,0 +1,73 @@
+#ifndef __AE483_PROFILE_H__
+#define __AE483_PROFILE_H__
+
+#include <stdint.h>
+
+// DWT cycle-counter instrumentation for the 500 Hz control path.
+//
+// On the Cortex-M4 (STM32F405) DWT->CYCCNT counts core clock cycles once
+// enabled; reading it costs one load, so a stage can be timestamped inside
+// controllerAE483() without disturbing what it measures. On non-ARM builds
+// (host-side replay) the counter stubs out to zero.
+
+#ifdef __arm__
+
+#define AE483_DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+#define AE483_DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define AE483_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+static inline void ae483ProfileInit(void)
+{
+  AE483_DEMCR |= (1 << 24);   // TRCENA: enable the DWT block
+  AE483_DWT_CYCCNT = 0;
+  AE483_DWT_CTRL |= 1;        // CYCCNTENA: start the cycle counter
+}
+
+static inline uint32_t ae483ProfileNow(void)
+{
+  return AE483_DWT_CYCCNT;
+}
+
+#else
+
+static inline void ae483ProfileInit(void)
+{
+}
+
+static inline uint32_t ae483ProfileNow(void)
+{
+  return 0;
+}
+
+#endif
+
+// Per-stage statistics: most recent sample, min, max, and an exponentially
+// weighted moving average (alpha = 1/64, cheap shift-free float update)
+typedef struct {
+  uint32_t last;
+  uint32_t min;
+  uint32_t max;
+  float ewma;
+} ae483ProfileStage_t;
+
+static inline void ae483ProfileStageReset(ae483ProfileStage_t *s)
+{
+  s->last = 0;
+  s->min = UINT32_MAX;
+  s->max = 0;
+  s->ewma = 0.0f;
+}
+
+static inline void ae483ProfileStageUpdate(ae483ProfileStage_t *s, uint32_t cycles)
+{
+  s->last = cycles;
+  if (cycles < s->min) {
+    s->min = cycles;
+  }
+  if (cycles > s->max) {
+    s->max = cycles;
+  }
+  s->ewma += ((float)cycles - s->ewma) * (1.0f/64.0f);
+}
+
+#endif // __AE483_PROFILE_H__
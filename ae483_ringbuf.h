@@ -0,0 +1,53 @@
+#ifndef __AE483_RINGBUF_H__
+#define __AE483_RINGBUF_H__
+
+#include <stdint.h>
+
+// Small lock-free single-producer single-consumer ring buffer for sensor
+// samples. The producer is a sensor callback (ae483UpdateWithFlow /
+// ae483UpdateWithTOF), the consumer is the 500 Hz controllerAE483() tick.
+// Capacity is a power of two so indices wrap with a mask; head is written by
+// the producer only and tail by the consumer only, so no critical section is
+// needed on the Cortex-M4 (aligned 32-bit loads and stores are atomic).
+
+#define AE483_RINGBUF_SIZE 8
+#define AE483_RINGBUF_MASK (AE483_RINGBUF_SIZE - 1)
+
+typedef struct {
+  float samples[AE483_RINGBUF_SIZE];
+  volatile uint32_t head; // written by producer only
+  uint32_t tail;          // written by consumer only
+} ae483Ringbuf_t;
+
+static inline void ae483RingbufPut(ae483Ringbuf_t *rb, float sample)
+{
+  uint32_t head = rb->head;
+  rb->samples[head & AE483_RINGBUF_MASK] = sample;
+  rb->head = head + 1;
+}
+
+// Consume all samples queued since the last call and return how many there
+// were; *avg gets their running-sum average and is left untouched if none
+// arrived. If the producer lapped the consumer, the oldest samples are
+// dropped rather than blocking either side.
+static inline uint32_t ae483RingbufDrainAvg(ae483Ringbuf_t *rb, float *avg)
+{
+  uint32_t head = rb->head;
+  uint32_t n = head - rb->tail;
+  if (n == 0) {
+    return 0;
+  }
+  if (n > AE483_RINGBUF_SIZE) {
+    rb->tail = head - AE483_RINGBUF_SIZE;
+    n = AE483_RINGBUF_SIZE;
+  }
+  float sum = 0.0f;
+  for (uint32_t i = rb->tail; i != head; i++) {
+    sum += rb->samples[i & AE483_RINGBUF_MASK];
+  }
+  rb->tail = head;
+  *avg = sum / (float)n;
+  return n;
+}
+
+#endif // __AE483_RINGBUF_H__
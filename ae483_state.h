@@ -0,0 +1,34 @@
+#ifndef __AE483_STATE_H__
+#define __AE483_STATE_H__
+
+#include <stdint.h>
+
+// Shared controller state for the AE483 stack.
+//
+// Everything the observer writes, the control law reads, and the log system
+// snapshots lives in this one packed struct instead of 40+ scattered static
+// floats: the hot observer fields are grouped at the front so the tick's
+// working set is one or two cache lines, and the batched binary log
+// (ae483_batchlog) snapshots the whole thing with a single struct copy.
+//
+// Field order is part of the binary log record format -- keep
+// ae483_binlog.py in sync when changing it.
+
+typedef struct __attribute__((packed)) {
+  // State estimates (hot: written by the observer every tick, read by the
+  // control law)
+  float o_x, o_y, o_z;
+  float psi, theta, phi;
+  float v_x, v_y, v_z;
+  float w_x, w_y, w_z;
+  // Measurements
+  float n_x, n_y, r, a_z;
+  // Setpoint
+  float o_x_des, o_y_des, o_z_des;
+  // Input
+  float tau_x, tau_y, tau_z, f_z;
+  // Motor power commands
+  uint16_t m_1, m_2, m_3, m_4;
+} ae483State_t;
+
+#endif // __AE483_STATE_H__
@@ -0,0 +1,159 @@
+#include "ae483_trajectory.h"
+
+// Two segment banks: `front` is the one being flown, the other receives
+// uploads. The CRTP callbacks only ever touch the idle bank and the
+// 500 Hz tick only ever reads the front bank, so the swap (flipping
+// `front` inside the tick) is the only hand-off point.
+static ae483TrajSegment_t banks[2][AE483_TRAJ_MAX_SEGMENTS];
+static int bank_count[2] = {0, 0};
+static int front = 0;
+static int upload_floats = 0; // floats received for the segment being filled
+static bool active = false;
+static bool swap_pending = false;
+
+// Playback state of the front bank
+static float seg_t = 0.0f;   // time within the current segment
+static int seg_i = 0;        // index of the current segment
+static float traj_t = 0.0f;  // time since the trajectory started
+
+void ae483TrajReset(void)
+{
+  bank_count[1 - front] = 0;
+  upload_floats = 0;
+  swap_pending = false;
+}
+
+// The upload is a flat float stream; segments do not need to align with the
+// three-float packets, so each float is routed to its slot individually.
+static void feedOne(float value)
+{
+  int back = 1 - front;
+  if (bank_count[back] >= AE483_TRAJ_MAX_SEGMENTS) {
+    return;
+  }
+  ae483TrajSegment_t *seg = &banks[back][bank_count[back]];
+  float *slot = &seg->duration; // floats of a segment are laid out in order
+  slot[upload_floats] = value;
+  upload_floats++;
+  if (upload_floats == AE483_TRAJ_FLOATS_PER_SEGMENT) {
+    upload_floats = 0;
+    bank_count[back]++;
+  }
+}
+
+void ae483TrajFeed(float a, float b, float c)
+{
+  feedOne(a);
+  feedOne(b);
+  feedOne(c);
+}
+
+int ae483TrajCount(void)
+{
+  return bank_count[1 - front];
+}
+
+static void swapBanks(void)
+{
+  front = 1 - front;
+  bank_count[1 - front] = 0;
+  upload_floats = 0;
+  seg_t = 0.0f;
+  seg_i = 0;
+  traj_t = 0.0f;
+  swap_pending = false;
+  active = (bank_count[front] > 0);
+}
+
+void ae483TrajStart(void)
+{
+  if (bank_count[1 - front] == 0) {
+    return;
+  }
+  if (active) {
+    // Finish the segment in progress first so the handover never cuts a
+    // stroke in half; ae483TrajTick performs the swap at the boundary
+    swap_pending = true;
+  } else {
+    swapBanks();
+  }
+}
+
+bool ae483TrajActive(void)
+{
+  return active;
+}
+
+bool ae483TrajSwapPending(void)
+{
+  return swap_pending;
+}
+
+float ae483TrajTime(void)
+{
+  return traj_t;
+}
+
+// Position, velocity and acceleration of one axis in a single Horner pass:
+// the derivative accumulators ride along with the value, so all three cost
+// six multiply-adds per axis for a cubic
+static void hornerPVA(const float c[AE483_TRAJ_COEFFS], float s,
+                      float *p, float *v, float *a)
+{
+  float value = c[AE483_TRAJ_COEFFS - 1];
+  float deriv = 0.0f;
+  float deriv2 = 0.0f;
+  for (int i = AE483_TRAJ_COEFFS - 2; i >= 0; i--) {
+    deriv2 = deriv2 * s + 2.0f * deriv;
+    deriv = deriv * s + value;
+    value = value * s + c[i];
+  }
+  *p = value;
+  *v = deriv;
+  *a = deriv2;
+}
+
+bool ae483TrajTick(float dt, ae483TrajSample_t *out)
+{
+  seg_t += dt;
+  traj_t += dt;
+
+  // Walk segment boundaries covered by this step; each one is a legal
+  // point to swap in the next uploaded bank
+  while (seg_i < bank_count[front] - 1 &&
+         seg_t >= banks[front][seg_i].duration) {
+    seg_t -= banks[front][seg_i].duration;
+    seg_i++;
+    if (swap_pending) {
+      swapBanks();
+    }
+  }
+  const ae483TrajSegment_t *seg = &banks[front][seg_i];
+
+  bool within = (seg_t <= seg->duration);
+  if (!within) {
+    if (swap_pending) {
+      // End of the trajectory is also a boundary
+      swapBanks();
+      seg = &banks[front][seg_i];
+      within = true;
+    } else {
+      // Playback is over: evaluate the final position one last time and
+      // deactivate, so control returns to streamed setpoints — otherwise
+      // the modeDisable gate in the controller is unreachable and a stop
+      // setpoint can never cut the motors after a painting
+      seg_t = seg->duration;
+      active = false;
+    }
+  }
+  hornerPVA(seg->c_x, seg_t, &out->x, &out->vx, &out->ax);
+  hornerPVA(seg->c_y, seg_t, &out->y, &out->vy, &out->ay);
+  hornerPVA(seg->c_z, seg_t, &out->z, &out->vz, &out->az);
+  out->light = seg->light;
+  if (!within) {
+    out->vx = out->vy = out->vz = 0.0f;
+    out->ax = out->ay = out->az = 0.0f;
+    out->light = 0.0f;
+  }
+  return within;
+}
@@ -0,0 +1,90 @@
+#ifndef __AE483_TRAJECTORY_H__
+#define __AE483_TRAJECTORY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Onboard trajectory buffer for light-painting flights.
+//
+// Instead of streaming position setpoints over the radio (~10 Hz, visibly
+// segmented curves), the client uploads a compact table of cubic polynomial
+// segments before takeoff through ae483UpdateWithData() and
+// controllerAE483() evaluates the desired position at the full tick rate
+// with Horner's rule.
+//
+// Upload protocol: set the traj_reset param, then send the segments as a
+// flat float stream, three floats per AE483Data packet. Each segment is
+// 14 floats:
+//
+//   duration, c_x[0..3], c_y[0..3], c_z[0..3], light
+//
+// where each axis is evaluated as c[0] + c[1]*s + c[2]*s^2 + c[3]*s^3 with
+// s the time in seconds since the segment started, and light is the LED
+// intensity (0..1) held over the segment — driven onboard so stroke on/off
+// edges are phase-locked to position instead of jittered by radio latency.
+// Segments need not align with packet boundaries. Set the traj_start param
+// to begin following.
+//
+// The buffer is double banked for back-to-back paintings: uploads always
+// fill the idle bank, so the next image can stream up while the current
+// one is flying. traj_start while already flying arms a swap that the
+// evaluator performs at the next segment boundary (or at the end of the
+// current trajectory), so the handover never cuts a stroke in half and
+// there is no hover-idle time between images.
+
+#define AE483_TRAJ_MAX_SEGMENTS 32
+#define AE483_TRAJ_COEFFS 4
+#define AE483_TRAJ_FLOATS_PER_SEGMENT (2 + 3 * AE483_TRAJ_COEFFS)
+
+typedef struct {
+  float duration;
+  float c_x[AE483_TRAJ_COEFFS];
+  float c_y[AE483_TRAJ_COEFFS];
+  float c_z[AE483_TRAJ_COEFFS];
+  float light; // LED intensity (0..1) held over this segment
+} ae483TrajSegment_t;
+
+// One evaluated point of the trajectory: desired position plus its first
+// two time derivatives, which the polynomial form gives almost for free
+// (the controller uses them as feed-forward so tracking is tick-rate
+// rather than radio-latency bound)
+typedef struct {
+  float x, y, z;
+  float vx, vy, vz;
+  float ax, ay, az;
+  float light;
+} ae483TrajSample_t;
+
+// Clear the idle bank and restart the upload stream into it (the bank
+// currently being flown, if any, is untouched)
+void ae483TrajReset(void);
+
+// Append three floats of the upload stream (one AE483Data packet)
+void ae483TrajFeed(float a, float b, float c);
+
+// Number of complete segments uploaded to the idle bank so far
+int ae483TrajCount(void);
+
+// Begin following the uploaded bank. Idle: takes effect immediately.
+// Already flying: arms a bank swap at the next segment boundary.
+void ae483TrajStart(void);
+
+// True while a trajectory is being followed
+bool ae483TrajActive(void);
+
+// True while a bank swap is armed but not yet performed
+bool ae483TrajSwapPending(void);
+
+// Playback time within the current trajectory, for logging
+float ae483TrajTime(void);
+
+// Advance playback by dt and evaluate the desired position, velocity and
+// acceleration, performing any armed bank swap at a segment boundary.
+// Past the end of the last segment (with no swap armed) the final
+// position is evaluated once more with zero velocity and acceleration and
+// the light off, and playback deactivates — control returns to streamed
+// setpoints, so the client can land the drone or stop the motors after a
+// painting; returns false in that case.
+bool ae483TrajTick(float dt, ae483TrajSample_t *out);
+
+#endif // __AE483_TRAJECTORY_H__
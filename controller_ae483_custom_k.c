@@ -6,6 +6,19 @@
 #include "num.h"
 #include "math3d.h"
 
+#include "ae483_ekf.h"
+#include "ae483_ringbuf.h"
+#include "ae483_state.h"
+#include "ae483_gains.h"
+#include "ae483_profile.h"
+#include "ae483_batchlog.h"
+#include "ae483_trajectory.h"
+#include "ae483_lightdeck.h"
+
+#ifdef AE483_OBSERVER_FIXEDPOINT
+#include "ae483_fixq.h"
+#endif
+
 // Sensor measurements
 // - tof (from the z ranger on the flow deck)
 static uint16_t tof_count = 0;
@@ -14,59 +27,171 @@ static float tof_distance = 0.0f;
 static uint16_t flow_count = 0;
 static float flow_dpixelx = 0.0f;
 static float flow_dpixely = 0.0f;
+// - ring buffers so no sample is dropped if several packets arrive between
+//   controller ticks (producer: sensor callback, consumer: controllerAE483)
+static ae483Ringbuf_t tof_buf;
+static ae483Ringbuf_t flow_x_buf;
+static ae483Ringbuf_t flow_y_buf;
+// - anchor distances (from the loco positioning deck, if installed); each
+//   sample carries its anchor position so the consumer needs no anchor
+//   table, hence a struct ring with the same producer/consumer scheme as
+//   ae483_ringbuf.h rather than a scalar one
+#define AE483_DIST_BUF_SIZE 8
+#define AE483_DIST_BUF_MASK (AE483_DIST_BUF_SIZE - 1)
+typedef struct {
+  float x, y, z; // anchor position
+  float d;       // measured distance to it
+} ae483DistSample_t;
+static ae483DistSample_t dist_samples[AE483_DIST_BUF_SIZE];
+static volatile uint32_t dist_head = 0; // written by producer only
+static uint32_t dist_tail = 0;          // written by consumer only
+static uint16_t dist_count = 0;
+// - mocap pose (external, over CRTP): a latest-value mailbox rather than a
+//   ring, because a newer full pose supersedes any older one outright. The
+//   producer writes the struct before bumping the sequence counter; a torn
+//   read can at worst blend two adjacent packets a few ms apart, which is
+//   harmless at mocap rates.
+typedef struct {
+  float x, y, z;
+  float psi, theta, phi;
+} ae483PoseSample_t;
+static ae483PoseSample_t pose_latest;
+static volatile uint16_t pose_seq = 0;  // bumped by producer after write
+static uint16_t pose_seq_last = 0;
+static uint16_t pose_count = 0;
 
-// Parameters
-static bool use_observer = false;
+// Parameters (ae483_use_observer and the mode switches are non-static so the SIL
+// replay harness in sil/ can drive them; CRTP param names are unchanged)
+bool ae483_use_observer = false;
 static bool reset_observer = false;
+static bool use_iterative_kalman = false;
+static bool recompute_kalman_gains = false;
+bool ae483_use_ekf = false;
+static bool use_batchlog = false;
+
+// Onboard trajectory following (see ae483_trajectory.h for the upload
+// protocol): traj_reset clears the buffer for a new upload, traj_start
+// begins following it at the full tick rate
+static bool traj_reset = false;
+static bool traj_start = false;
+static float traj_t = 0.0f;
+static uint16_t traj_count = 0;
+
+// Feed-forward terms from the trajectory derivatives (zero when following
+// streamed setpoints, so the error-feedback path is unchanged)
+static float v_x_des = 0.0f;
+static float v_y_des = 0.0f;
+static float v_z_des = 0.0f;
+static float theta_des = 0.0f;
+static float phi_des = 0.0f;
+static float a_z_des = 0.0f;
+
+// Commanded light-deck intensity from the trajectory's light channel
+// (driven from the same evaluator sample as the position setpoint)
+static float light_des = 0.0f;
+
+// Shared controller state: observer writes, control law reads, log system
+// snapshots (see ae483_state.h for the layout; non-static for the SIL
+// harness)
+ae483State_t ae483_state;
 
-// State
-static float o_x = 0.0f;
-static float o_y = 0.0f;
-static float o_z = 0.0f;
-static float psi = 0.0f;
-static float theta = 0.0f;
-static float phi = 0.0f;
-static float v_x = 0.0f;
-static float v_y = 0.0f;
-static float v_z = 0.0f;
-static float w_x = 0.0f;
-static float w_y = 0.0f;
-static float w_z = 0.0f;
-
-// Setpoint
-static float o_x_des = 0.0f;
-static float o_y_des = 0.0f;
-static float o_z_des = 0.0f;
-
-// Input
-static float tau_x = 0.0f;
-static float tau_y = 0.0f;
-static float tau_z = 0.0f;
-static float f_z = 0.0f;
-
-// Motor power command
-static uint16_t m_1 = 0;
-static uint16_t m_2 = 0;
-static uint16_t m_3 = 0;
-static uint16_t m_4 = 0;
-
-// Measurements
-static float n_x = 0.0f;
-static float n_y = 0.0f;
-static float r = 0.0f;
-static float a_z = 0.0f;
-
-// Constants
+// Constants. The controller is dual rate: a lean attitude inner loop runs
+// on every invocation (RATE_MAIN_LOOP, with dt measured from the tick
+// counter so the SIL harness can drive it at its own rate), and the
+// position/velocity observer and setpoint stage run at POSITION_RATE where
+// the flow/tof sensors actually update.
 static float k_flow = 4.09255568f;
 static float g = 9.81f;
-static float dt = 0.002f;
+static float dt_outer = 0.01f;
 static float o_z_eq = 0.5f;
 
+// Inner-loop dt from the tick counter (RATE_MAIN_LOOP ticks per second)
+static uint32_t inner_tick_last = 0;
+static bool inner_tick_valid = false;
+
 // Measurement errors
 static float n_x_err = 0.0f;
 static float n_y_err = 0.0f;
 static float r_err = 0.0f;
 
+// Measurement-rate decimation: corrections only run when a new sample has
+// arrived since the last outer iteration, with the correction scaled by
+// the number of iterations it covers (capped so a long sensor dropout
+// cannot cause a jump; 10 iterations is 100 ms at POSITION_RATE)
+static uint16_t tof_count_last = 0;
+static uint16_t flow_count_last = 0;
+static uint16_t tof_ticks = 0;
+static uint16_t flow_ticks = 0;
+#define AE483_MAX_CORRECT_TICKS 10
+
+// Cycle-count profile of the control tick, per stage (see ae483_profile.h)
+static ae483ProfileStage_t prof_obs;
+static ae483ProfileStage_t prof_ctrl;
+static ae483ProfileStage_t prof_mix;
+static bool reset_profile = false;
+
+// Tick watchdog: inter-invocation timing of the inner loop, measured
+// with the DWT cycle counter (unsigned subtraction handles counter wrap)
+#define AE483_CPU_MHZ 168
+#define AE483_TICK_OVERRUN_US 250.0f
+static uint32_t last_exec_cycles = 0;
+static bool exec_valid = false;
+static uint16_t num_overrun = 0;
+static float max_jitter_us = 0.0f;
+
+// Ticks where the mixer had to rescale torque to avoid motor clipping
+static uint16_t num_sat = 0;
+
+// Online w_z gyro-bias estimator: psi integrates the gyro, so a few
+// hundredths of a deg/s of bias rotates a 60 s painting visibly. While the
+// commanded yaw torque is essentially zero and the measured rate is near
+// the current bias estimate — the drone has no reason to be yawing and is
+// not — the measured rate IS the bias, and a slow recursive average tracks
+// it, including its drift with board temperature over a session. No
+// derivative term or attitude filter; two flops per tick. The estimate is
+// deliberately not cleared by reset_observer (bias is a property of the
+// gyro, not of the flight).
+#define AE483_WZ_BIAS_TAU_Z 1e-4f // |tau_z| below this is "no yaw command"
+#define AE483_WZ_BIAS_RATE 0.1f   // rad/s; never learn during actual rotation
+#define AE483_WZ_BIAS_ALPHA 5e-4f // per tick; ~2 s time constant at 1 kHz
+static float w_z_bias = 0.0f;
+
+// Innovation gating: over reflective floors the flow sensor emits
+// occasional wild dpixel spikes, and ingesting one at full gain twitches
+// the drone mid-exposure. A correction is skipped when its squared
+// innovation exceeds gate^2 times the predicted innovation variance
+// (S = P + Q + R with the converged covariance). flow_gate is in sigmas;
+// rejected samples are counted for the log.
+static float flow_gate = 3.0f;
+static uint16_t num_flow_rej = 0;
+static uint16_t num_tof_rej = 0;
+
+// UWB ranges get their own gate, in meters rather than sigmas: multipath
+// off the floor or a body between drone and anchor lengthens the range by
+// an arbitrary amount, so the residual distribution has no useful sigma
+static float dist_gate = 1.0f;
+static uint16_t num_dist_rej = 0;
+
+// Pose latency compensation: mocap packets arrive 20-40 ms stale over the
+// radio, so fusing one against the current estimate drags the observer
+// backward in time and fights it instead of tightening it. The outer loop
+// records a short history of (v, w) states; on a fresh pose the measured
+// pose is forward-propagated by pose_latency_ms of recorded motion before
+// it is compared and blended. A pose whose position innovation exceeds
+// pose_gate (meters; marker dropouts produce garbage poses, not noise) is
+// rejected and counted.
+#define AE483_POSE_HIST 8   // x dt_outer = 80 ms of history
+#define AE483_POSE_HIST_MASK (AE483_POSE_HIST - 1)
+static float hist_v[AE483_POSE_HIST][3];
+static float hist_w[AE483_POSE_HIST][3];
+static uint32_t hist_head = 0;
+static float pose_latency_ms = 30.0f;
+static float pose_gate = 1.0f;
+static uint16_t num_pose_rej = 0;
+
+// Records dropped by the binary batch log (mirrored for LOG_ADD)
+static uint32_t blog_dropped = 0;
+
 /////////////////////////////////////// KALMAN FILTER VARIABLES
 // O_Z
 float oz_measured;
@@ -75,8 +200,8 @@ float K_oz;
 float P_temp_oz;
 float P_last_oz;
 float oz_est_new;
-static float Q_oz = 0.1f;
-static float R_oz = 0.06350709061837238f*0.06350709061837238f;
+float Q_oz = 0.1f;
+float R_oz = 0.06350709061837238f*0.06350709061837238f;
 
 // V_X
 float vx_measured;
@@ -85,8 +210,8 @@ float K_vx;
 float P_temp_vx;
 float P_last_vx;
 float vx_est_new;
-static float Q_vx = 0.1f;
-static float R_vx = 0.7570370678653842f*0.7570370678653842f;
+float Q_vx = 0.1f;
+float R_vx = 0.7570370678653842f*0.7570370678653842f;
 
 // V_Y
 float vy_measured;
@@ -95,33 +220,245 @@ float K_vy;
 float P_temp_vy;
 float P_last_vy;
 float vy_est_new;
-static float Q_vy = 0.1f;
-static float R_vy = 0.7698969611565406f*0.7698969611565406f;
+float Q_vy = 0.1f;
+float R_vy = 0.7698969611565406f*0.7698969611565406f;
+
+// Observer correction gains (non-static so the SIL sweep driver in
+// sil/sweep.py can tune them without a reflash)
+float ae483_L_theta = 0.029925f;
+float ae483_L_phi = 0.024252f;
+float ae483_L_vz = 5.676619f;
+float ae483_L_dist = 0.2f;
+float ae483_L_pose = 0.5f;
+
+// Steady-state Kalman gains and covariances (precomputed at init or on
+// recompute_kalman_gains; the covariances seed P_last_* on warm start so
+// the iterative path also skips its convergence transient)
+static float K_oz_ss = 0.0f;
+static float K_vx_ss = 0.0f;
+static float K_vy_ss = 0.0f;
+static float P_oz_ss = 0.0f;
+static float P_vx_ss = 0.0f;
+static float P_vy_ss = 0.0f;
+
+// Observer convergence flag for the client: set once the height innovation
+// has stayed small for a run of fresh tof samples, cleared on reset (the
+// exposure can start as soon as this reads 1 instead of a fixed hover wait)
+#define AE483_CONV_THRESH 0.05f
+#define AE483_CONV_SAMPLES 25
+static uint8_t obs_converged = 0;
+static uint16_t conv_count = 0;
+
+#ifdef AE483_OBSERVER_FIXEDPOINT
+// Q16.16 mirror of the scalar observer kernel (see ae483_fixq.h): the
+// kernel runs integer-only so the FPU stays out of the estimator path,
+// and floats only cross the boundary where measurements enter and where
+// the estimate is published to ae483_state. Attitude stays float (the
+// inner loop owns it), and the iterative Kalman tuning path is float-only
+// (use_iterative_kalman has no effect in this build).
+static q16_t fx_o_x, fx_o_y, fx_o_z;
+static q16_t fx_v_x, fx_v_y, fx_v_z;
+static q16_t fx_K_oz, fx_K_vx, fx_K_vy;
+static q16_t fx_dt, fx_g_dt;
+static q16_t fx_k_flow, fx_inv_k_flow, fx_inv_oz_eq, fx_L_vz_dt;
+// Innovation-gate thresholds gate^2 * S, refreshed with the gains (change
+// flow_gate, then set recompute_kalman_gains)
+static q16_t fx_gate2S_oz, fx_gate2S_vx, fx_gate2S_vy;
+#endif
+
+// Iterate the scalar covariance recursion to its fixed point, then fold the
+// ten per-tick measurement updates into one effective gain: applying the
+// converged gain K ten times moves the estimate by 1 - (1 - K)^10 of the
+// innovation, so a single fused multiply-add reproduces the loop.
+static float steadyStateKalmanGain(float Q, float R, float *P_ss)
+{
+  float P = 0.0f;
+  float K = 0.0f;
+  for (int i=0;i<100;i++) {
+    float P_temp = P + Q;
+    K = P_temp * (1.0f/(P_temp + R));
+    P = (1.0f-K) * P_temp;
+  }
+  *P_ss = P;
+  float K_eff = 1.0f;
+  for (int i=0;i<10;i++) {
+    K_eff *= (1.0f-K);
+  }
+  return 1.0f - K_eff;
+}
+
+static void computeSteadyStateKalmanGains(void)
+{
+  K_oz_ss = steadyStateKalmanGain(Q_oz, R_oz, &P_oz_ss);
+  K_vx_ss = steadyStateKalmanGain(Q_vx, R_vx, &P_vx_ss);
+  K_vy_ss = steadyStateKalmanGain(Q_vy, R_vy, &P_vy_ss);
+#ifdef AE483_OBSERVER_FIXEDPOINT
+  fx_K_oz = q16FromFloat(K_oz_ss);
+  fx_K_vx = q16FromFloat(K_vx_ss);
+  fx_K_vy = q16FromFloat(K_vy_ss);
+  fx_gate2S_oz = q16FromFloat(flow_gate*flow_gate * (P_oz_ss + Q_oz + R_oz));
+  fx_gate2S_vx = q16FromFloat(flow_gate*flow_gate * (P_vx_ss + Q_vx + R_vx));
+  fx_gate2S_vy = q16FromFloat(flow_gate*flow_gate * (P_vy_ss + Q_vy + R_vy));
+#endif
+}
+
+static void trackConvergence(float innovation)
+{
+  if (fabsf(innovation) < AE483_CONV_THRESH) {
+    if (conv_count < AE483_CONV_SAMPLES) {
+      conv_count++;
+    }
+    obs_converged = (conv_count >= AE483_CONV_SAMPLES);
+  } else {
+    conv_count = 0;
+    obs_converged = 0;
+  }
+}
+
+// Drain the anchor-distance ring, folding each range into the horizontal
+// position estimate as it arrives: one scalar correction per measurement
+// along the anchor ray, no batch trilateration solve. With
+// d_pred = |p - a|, the innovation moves the estimate by
+// L_dist * (d - d_pred) along the unit ray — the gradient of the range
+// model — so anchors in different directions pull o_x/o_y toward the
+// trilaterated fix over a few samples. o_z stays with the tof, which is an
+// order of magnitude more accurate than UWB ranging at our flight heights.
+// Under use_ekf each sample goes through the engine instead, where the
+// full covariance weighs it. Returns the number of corrections applied.
+static uint32_t correctWithAnchorDistances(void)
+{
+  uint32_t head = dist_head;
+  uint32_t n = head - dist_tail;
+  if (n == 0) {
+    return 0;
+  }
+  if (n > AE483_DIST_BUF_SIZE) {
+    dist_tail = head - AE483_DIST_BUF_SIZE;
+  }
+  uint32_t applied = 0;
+  for (uint32_t i = dist_tail; i != head; i++) {
+    const ae483DistSample_t *s = &dist_samples[i & AE483_DIST_BUF_MASK];
+    float dx = ae483_state.o_x - s->x;
+    float dy = ae483_state.o_y - s->y;
+    float dz = ae483_state.o_z - s->z;
+    float d_pred = sqrtf(dx*dx + dy*dy + dz*dz);
+    if (d_pred < 1e-3f) {
+      // Degenerate geometry (estimate on top of the anchor)
+      continue;
+    }
+    float innovation = s->d - d_pred;
+    if (fabsf(innovation) > dist_gate) {
+      num_dist_rej++;
+      continue;
+    }
+    if (ae483_use_ekf) {
+      ae483EkfCorrectDistance(s->x, s->y, s->z, s->d);
+    } else {
+      float k = ae483_L_dist * innovation / d_pred;
+      ae483_state.o_x += k * dx;
+      ae483_state.o_y += k * dy;
+    }
+    applied++;
+  }
+  dist_tail = head;
+  return applied;
+}
+
+// Wrap an angle difference into (-pi, pi]: the onboard psi integrates
+// unbounded while the mocap psi lives in [-pi, pi]
+static float wrapAngle(float a)
+{
+  while (a > (float)M_PI) {
+    a -= 2.0f * (float)M_PI;
+  }
+  while (a <= -(float)M_PI) {
+    a += 2.0f * (float)M_PI;
+  }
+  return a;
+}
+
+// Fuse the latest mocap pose, if a new one has arrived: forward-propagate
+// the stale measurement by pose_latency_ms of recorded (v, w) using the
+// same linearized model as the predict step, gate it, then blend all six
+// pose states toward it (or hand it to the EKF engine under use_ekf).
+// Returns nonzero if a correction was applied.
+static uint32_t correctWithPose(void)
+{
+  if (pose_seq == pose_seq_last) {
+    return 0;
+  }
+  pose_seq_last = pose_seq;
+  ae483PoseSample_t pose = pose_latest;
+
+  uint32_t n_lat = (uint32_t)(pose_latency_ms * 0.001f / dt_outer + 0.5f);
+  if (n_lat > AE483_POSE_HIST) {
+    n_lat = AE483_POSE_HIST;
+  }
+  for (uint32_t i = 1; i <= n_lat; i++) {
+    const float *v = hist_v[(hist_head - i) & AE483_POSE_HIST_MASK];
+    const float *w = hist_w[(hist_head - i) & AE483_POSE_HIST_MASK];
+    pose.x += dt_outer * v[0];
+    pose.y += dt_outer * v[1];
+    pose.z += dt_outer * v[2];
+    pose.psi += dt_outer * w[2];
+    pose.theta += dt_outer * w[1];
+    pose.phi += dt_outer * w[0];
+  }
+
+  float e_x = pose.x - ae483_state.o_x;
+  float e_y = pose.y - ae483_state.o_y;
+  float e_z = pose.z - ae483_state.o_z;
+  if (e_x*e_x + e_y*e_y + e_z*e_z > pose_gate*pose_gate) {
+    num_pose_rej++;
+    return 0;
+  }
+  float e_psi = wrapAngle(pose.psi - ae483_state.psi);
+  float e_theta = pose.theta - ae483_state.theta;
+  float e_phi = pose.phi - ae483_state.phi;
+
+  if (ae483_use_ekf) {
+    // Pass psi unwrapped near the engine estimate so its innovation is
+    // the wrapped one
+    ae483EkfCorrectPose(pose.x, pose.y, pose.z,
+                        ae483_state.psi + e_psi, pose.theta, pose.phi);
+  } else {
+    ae483_state.o_x += ae483_L_pose * e_x;
+    ae483_state.o_y += ae483_L_pose * e_y;
+    ae483_state.o_z += ae483_L_pose * e_z;
+    ae483_state.psi += ae483_L_pose * e_psi;
+    ae483_state.theta += ae483_L_pose * e_theta;
+    ae483_state.phi += ae483_L_pose * e_phi;
+  }
+  return 1;
+}
 
 void ae483UpdateWithTOF(tofMeasurement_t *tof)
 {
-  tof_distance = tof->distance;
+  ae483RingbufPut(&tof_buf, tof->distance);
   tof_count++;
 }
 
 void ae483UpdateWithFlow(flowMeasurement_t *flow)
 {
-  flow_dpixelx = flow->dpixelx;
-  flow_dpixely = flow->dpixely;
+  ae483RingbufPut(&flow_x_buf, flow->dpixelx);
+  ae483RingbufPut(&flow_y_buf, flow->dpixely);
   flow_count++;
 }
 
 void ae483UpdateWithDistance(distanceMeasurement_t *meas)
 {
-  // If you have a loco positioning deck, this function will be called
-  // each time a distance measurement is available. You will have to write
-  // code to handle these measurements. These data are available:
-  //
-  //  meas->anchorId  uint8_t   id of anchor with respect to which distance was measured
-  //  meas->x         float     x position of this anchor
-  //  meas->y         float     y position of this anchor
-  //  meas->z         float     z position of this anchor
-  //  meas->distance  float     the measured distance
+  // Loco positioning deck: queue the range with its anchor position; the
+  // outer loop folds each sample into the position estimate
+  // (correctWithAnchorDistances). The struct is written before head is
+  // advanced, same publication order as the scalar rings.
+  uint32_t head = dist_head;
+  ae483DistSample_t *s = &dist_samples[head & AE483_DIST_BUF_MASK];
+  s->x = meas->x;
+  s->y = meas->y;
+  s->z = meas->z;
+  s->d = meas->distance;
+  dist_head = head + 1;
+  dist_count++;
 }
 
 void ae483UpdateWithPosition(positionMeasurement_t *meas)
@@ -138,37 +475,69 @@ void ae483UpdateWithPosition(positionMeasurement_t *meas)
 
 void ae483UpdateWithPose(poseMeasurement_t *meas)
 {
-  // This function will be called each time you send an external "pose" measurement
-  // (position as x, y, z and orientation as quaternion) from the client, e.g., from
-  // a motion capture system. You will have to write code to handle these measurements.
-  // These data are available:
-  //
-  //  meas->x         float     x component of external position measurement
-  //  meas->y         float     y component of external position measurement
-  //  meas->z         float     z component of external position measurement
-  //  meas->quat.x    float     x component of quaternion from external orientation measurement
-  //  meas->quat.y    float     y component of quaternion from external orientation measurement
-  //  meas->quat.z    float     z component of quaternion from external orientation measurement
-  //  meas->quat.w    float     w component of quaternion from external orientation measurement
+  // Mocap fast-path: convert the quaternion to the ZYX Euler angles the
+  // observer carries and publish to the latest-pose mailbox; fusion (with
+  // latency compensation) happens in the outer loop, see correctWithPose()
+  float qw = meas->quat.w;
+  float qx = meas->quat.x;
+  float qy = meas->quat.y;
+  float qz = meas->quat.z;
+  pose_latest.x = meas->x;
+  pose_latest.y = meas->y;
+  pose_latest.z = meas->z;
+  pose_latest.psi = atan2f(2.0f*(qw*qz + qx*qy), 1.0f - 2.0f*(qy*qy + qz*qz));
+  pose_latest.theta = asinf(2.0f*(qw*qy - qz*qx));
+  pose_latest.phi = atan2f(2.0f*(qw*qx + qy*qz), 1.0f - 2.0f*(qx*qx + qy*qy));
+  pose_seq++;
+  pose_count++;
 }
 
 void ae483UpdateWithData(const struct AE483Data* data)
 {
-  // This function will be called each time AE483-specific data are sent
-  // from the client to the drone. You will have to write code to handle
-  // these data. For the example AE483Data struct, these data are:
-  //
-  //  data->x         float
-  //  data->y         float
-  //  data->z         float
-  //
-  // Exactly what "x", "y", and "z" mean in this context is up to you.
+  // AE483Data packets carry the trajectory upload stream: three floats per
+  // packet, appended to the segment buffer (set the traj_reset param first
+  // to restart the stream)
+  ae483TrajFeed(data->x, data->y, data->z);
+  traj_count = (uint16_t)ae483TrajCount();
 }
 
 
 void controllerAE483Init(void)
 {
-  // Do nothing
+  // Precompute the converged Kalman gains so the 500 Hz tick only pays for
+  // one fused multiply-add per axis
+  computeSteadyStateKalmanGains();
+
+  // Initialize the full multivariate EKF engine (used when ae483_use_ekf is
+  // set); it predicts at the outer-loop rate
+  ae483EkfConfig_t ekf_config;
+  ae483EkfDefaultConfig(&ekf_config);
+  ekf_config.dt = dt_outer;
+  ae483EkfInit(&ekf_config);
+
+#ifdef AE483_OBSERVER_FIXEDPOINT
+  // Convert the kernel constants once (the sweep-tunable gains are set
+  // before init, and recompute_kalman_gains refreshes the Kalman gains)
+  fx_dt = q16FromFloat(dt_outer);
+  fx_g_dt = q16FromFloat(g * dt_outer);
+  fx_k_flow = q16FromFloat(k_flow);
+  fx_inv_k_flow = q16FromFloat(1.0f / k_flow);
+  fx_inv_oz_eq = q16FromFloat(1.0f / o_z_eq);
+  fx_L_vz_dt = q16FromFloat(ae483_L_vz * dt_outer);
+  (void)use_iterative_kalman; // float-only tuning path, ignored here
+#endif
+
+  // Reset the binary batch log ring
+  ae483BatchlogInit();
+
+  // Light deck off until a trajectory commands it
+  ae483LightInit();
+
+  // Start the DWT cycle counter and clear the per-stage statistics
+  ae483ProfileInit();
+  ae483ProfileStageReset(&prof_obs);
+  ae483ProfileStageReset(&prof_ctrl);
+  ae483ProfileStageReset(&prof_mix);
 }
 
 bool controllerAE483Test(void)
@@ -183,165 +552,671 @@ void controllerAE483(control_t *control,
                      const state_t *state,
                      const uint32_t tick)
 {
-  if (RATE_DO_EXECUTE(ATTITUDE_RATE, tick)) {
-    // Everything in here runs at 500 Hz
-
-    // Desired position
-    o_x_des = setpoint->position.x;
-    o_y_des = setpoint->position.y;
-    o_z_des = setpoint->position.z;
-
-    // Measurements
-    w_x = radians(sensors->gyro.x);
-    w_y = radians(sensors->gyro.y);
-    w_z = radians(sensors->gyro.z);
-    a_z = g * sensors->acc.z;
-    n_x = flow_dpixelx;
-    n_y = flow_dpixely;
-    r = tof_distance;
+  if (RATE_DO_EXECUTE(POSITION_RATE, tick)) {
+    // Outer loop: setpoint stage and position/velocity observer, decimated
+    // to where the flow/tof sensors actually update
+
+    if (traj_reset) {
+      ae483TrajReset();
+      traj_count = 0;
+      traj_reset = false;
+    }
+    if (traj_start) {
+      // Idle: begins following immediately. Flying: arms a bank swap that
+      // the evaluator performs at the next segment boundary, so the next
+      // image can be uploaded and started without landing in between.
+      ae483TrajStart();
+      traj_start = false;
+    }
+
+    // Desired position: the buffered trajectory when one is being followed,
+    // otherwise the streamed setpoint
+    if (ae483TrajActive()) {
+      ae483TrajSample_t des;
+      ae483TrajTick(dt_outer, &des);
+      traj_t = ae483TrajTime();
+      ae483_state.o_x_des = des.x;
+      ae483_state.o_y_des = des.y;
+      ae483_state.o_z_des = des.z;
+      // Feed-forward from the trajectory derivatives, linearized about
+      // hover like the rest of the controller: the attitude that produces
+      // the desired lateral acceleration, and the desired velocity and
+      // vertical acceleration for the velocity/thrust terms in the inner
+      // loop
+      v_x_des = des.vx;
+      v_y_des = des.vy;
+      v_z_des = des.vz;
+      theta_des = des.ax / g;
+      phi_des = -des.ay / g;
+      a_z_des = des.az;
+      light_des = des.light;
+    } else {
+      ae483_state.o_x_des = setpoint->position.x;
+      ae483_state.o_y_des = setpoint->position.y;
+      ae483_state.o_z_des = setpoint->position.z;
+      v_x_des = 0.0f;
+      v_y_des = 0.0f;
+      v_z_des = 0.0f;
+      theta_des = 0.0f;
+      phi_des = 0.0f;
+      a_z_des = 0.0f;
+      light_des = 0.0f;
+    }
+    ae483LightSet(light_des);
+
+    // Drain the sensor ring buffers: average every sample that arrived
+    // since the last iteration instead of keeping only the most recent one
+    ae483RingbufDrainAvg(&tof_buf, &tof_distance);
+    ae483RingbufDrainAvg(&flow_x_buf, &flow_dpixelx);
+    ae483RingbufDrainAvg(&flow_y_buf, &flow_dpixely);
+    ae483_state.n_x = flow_dpixelx;
+    ae483_state.n_y = flow_dpixely;
+    ae483_state.r = tof_distance;
 
     if (reset_observer) {
-      o_x = 0.0f;
-      o_y = 0.0f;
-      o_z = 0.0f;
-      psi = 0.0f;
-      theta = 0.0f;
-      phi = 0.0f;
-      v_x = 0.0f;
-      v_y = 0.0f;
-      v_z = 0.0f;
+      // Warm start instead of zeroing: seed height from the latest tof
+      // sample, attitude and velocity from the stock estimator, and the
+      // scalar covariances from their pre-converged fixed points, so the
+      // estimate is usable within a few samples instead of after seconds
+      // of settling hover. (This runs here rather than in
+      // controllerAE483Init() because no sensor or estimator data exists
+      // yet at init time.)
+      ae483_state.o_x = state->position.x;
+      ae483_state.o_y = state->position.y;
+      ae483_state.o_z = (tof_count > 0) ? tof_distance : state->position.z;
+      ae483_state.psi = radians(state->attitude.yaw);
+      ae483_state.theta = - radians(state->attitude.pitch);
+      ae483_state.phi = radians(state->attitude.roll);
+      ae483_state.v_x = state->velocity.x;
+      ae483_state.v_y = state->velocity.y;
+      ae483_state.v_z = state->velocity.z;
+      P_last_oz = P_oz_ss;
+      P_last_vx = P_vx_ss;
+      P_last_vy = P_vy_ss;
+#ifdef AE483_OBSERVER_FIXEDPOINT
+      fx_o_x = q16FromFloat(ae483_state.o_x);
+      fx_o_y = q16FromFloat(ae483_state.o_y);
+      fx_o_z = q16FromFloat(ae483_state.o_z);
+      fx_v_x = q16FromFloat(ae483_state.v_x);
+      fx_v_y = q16FromFloat(ae483_state.v_y);
+      fx_v_z = q16FromFloat(ae483_state.v_z);
+#endif
+      ae483EkfReset();
+      conv_count = 0;
+      obs_converged = 0;
       reset_observer = false;
     }
 
-    // State estimates
-    if (use_observer) {
-    
-      // Compute each element of:
-      //   C x + D u - y
-      n_x_err = k_flow * ((v_x / o_z_eq) - w_y) - n_x;
-      n_y_err = k_flow * (w_x + (v_y / o_z_eq)) - n_y;
-      r_err = o_z - r;
-
-      // Update estimates LQR
-      o_x += dt * v_x;
-      o_y += dt * v_y;
-      psi += dt * w_z;
-      theta += dt * (w_y - 0.029925f*n_x_err);
-      phi += dt * (w_x - (-0.024252f*n_y_err));
-      v_z += dt * (a_z - g - 5.676619f*r_err);
+    if (reset_profile) {
+      ae483ProfileStageReset(&prof_obs);
+      ae483ProfileStageReset(&prof_ctrl);
+      ae483ProfileStageReset(&prof_mix);
+      num_overrun = 0;
+      max_jitter_us = 0.0f;
+      exec_valid = false;
+      reset_profile = false;
+    }
+
+    uint32_t t_outer = ae483ProfileNow();
+
+    // Check whether new measurements have arrived since the last
+    // iteration, so corrections only run at measurement rate
+    bool tof_fresh = (tof_count != tof_count_last);
+    bool flow_fresh = (flow_count != flow_count_last);
+    tof_count_last = tof_count;
+    flow_count_last = flow_count;
+    if (tof_ticks < AE483_MAX_CORRECT_TICKS) {
+      tof_ticks++;
+    }
+    if (flow_ticks < AE483_MAX_CORRECT_TICKS) {
+      flow_ticks++;
+    }
+
+    // Position/velocity estimates (attitude is propagated by the inner
+    // loop at full rate and re-anchored here)
+    if (ae483_use_observer && ae483_use_ekf) {
+
+      // Full multivariate filter: predict every iteration, correct only on
+      // fresh samples, with cross-covariance carried in the 9x9 engine
+      ae483EkfPredict(ae483_state.w_x, ae483_state.w_y, ae483_state.w_z, ae483_state.a_z);
+      if (tof_fresh) {
+        trackConvergence(ae483_state.o_z - ae483_state.r);
+        ae483EkfCorrectTOF(ae483_state.r);
+        tof_ticks = 0;
+      }
+      if (flow_fresh) {
+        ae483EkfCorrectFlowX(ae483_state.n_x, ae483_state.w_y);
+        ae483EkfCorrectFlowY(ae483_state.n_y, ae483_state.w_x);
+        flow_ticks = 0;
+      }
+
+      const float *x_ekf = ae483EkfState();
+      ae483_state.o_x = x_ekf[AE483_EKF_O_X];
+      ae483_state.o_y = x_ekf[AE483_EKF_O_Y];
+      ae483_state.o_z = x_ekf[AE483_EKF_O_Z];
+      ae483_state.psi = x_ekf[AE483_EKF_PSI];
+      ae483_state.theta = x_ekf[AE483_EKF_THETA];
+      ae483_state.phi = x_ekf[AE483_EKF_PHI];
+      ae483_state.v_x = x_ekf[AE483_EKF_V_X];
+      ae483_state.v_y = x_ekf[AE483_EKF_V_Y];
+      ae483_state.v_z = x_ekf[AE483_EKF_V_Z];
+
+      // Anchor ranges go through the engine (the gate in the drain helper
+      // reads the just-published state); re-publish position if any landed
+      if (correctWithAnchorDistances() > 0) {
+        ae483_state.o_x = x_ekf[AE483_EKF_O_X];
+        ae483_state.o_y = x_ekf[AE483_EKF_O_Y];
+        ae483_state.o_z = x_ekf[AE483_EKF_O_Z];
+      }
+
+      // Mocap pose, latency-compensated; re-publish the pose states if a
+      // correction landed
+      if (correctWithPose() > 0) {
+        ae483_state.o_x = x_ekf[AE483_EKF_O_X];
+        ae483_state.o_y = x_ekf[AE483_EKF_O_Y];
+        ae483_state.o_z = x_ekf[AE483_EKF_O_Z];
+        ae483_state.psi = x_ekf[AE483_EKF_PSI];
+        ae483_state.theta = x_ekf[AE483_EKF_THETA];
+        ae483_state.phi = x_ekf[AE483_EKF_PHI];
+      }
+
+    } else if (ae483_use_observer) {
+
+#ifdef AE483_OBSERVER_FIXEDPOINT
+
+      // Integer-only scalar kernel, mirroring the float path op for op
+      // (see ae483_fixq.h for why Q16.16 covers the state ranges)
+      q16_t fx_theta = q16FromFloat(ae483_state.theta);
+      q16_t fx_phi = q16FromFloat(ae483_state.phi);
+      q16_t fx_a_err = q16FromFloat(ae483_state.a_z - g);
+
+      fx_o_x += q16Mul(fx_dt, fx_v_x);
+      fx_o_y += q16Mul(fx_dt, fx_v_y);
+      fx_v_z += q16Mul(fx_dt, fx_a_err);
+      fx_o_z += q16Mul(fx_dt, fx_v_z);
+      fx_v_x += q16Mul(fx_g_dt, fx_theta);
+      fx_v_y -= q16Mul(fx_g_dt, fx_phi);
+
+      if (recompute_kalman_gains) {
+        computeSteadyStateKalmanGains();
+        recompute_kalman_gains = false;
+      }
+
+      if (flow_fresh) {
+        q16_t fx_n_x = q16FromFloat(ae483_state.n_x);
+        q16_t fx_n_y = q16FromFloat(ae483_state.n_y);
+        q16_t fx_r = q16FromFloat(ae483_state.r);
+        q16_t fx_w_x = q16FromFloat(ae483_state.w_x);
+        q16_t fx_w_y = q16FromFloat(ae483_state.w_y);
+
+        q16_t fx_nx_err = q16Mul(fx_k_flow, q16Mul(fx_v_x, fx_inv_oz_eq) - fx_w_y) - fx_n_x;
+        q16_t fx_ny_err = q16Mul(fx_k_flow, fx_w_x + q16Mul(fx_v_y, fx_inv_oz_eq)) - fx_n_y;
+        n_x_err = q16ToFloat(fx_nx_err);
+        n_y_err = q16ToFloat(fx_ny_err);
+
+        // Innovation gate against the precomputed gate^2 * S thresholds
+        q16_t fx_vx_meas = q16Mul(q16Mul(fx_n_x, fx_r), fx_inv_k_flow) + q16Mul(fx_r, fx_w_y);
+        q16_t fx_vy_meas = q16Mul(q16Mul(fx_n_y, fx_r), fx_inv_k_flow) - q16Mul(fx_r, fx_w_x);
+        q16_t fx_innov_vx = fx_vx_meas - fx_v_x;
+        q16_t fx_innov_vy = fx_vy_meas - fx_v_y;
+        bool rej_x = (q16Mul(fx_innov_vx, fx_innov_vx) > fx_gate2S_vx);
+        bool rej_y = (q16Mul(fx_innov_vy, fx_innov_vy) > fx_gate2S_vy);
+        num_flow_rej += rej_x + rej_y;
+
+        // The attitude corrections stay in the float domain because the
+        // inner loop owns attitude
+        float dt_flow = dt_outer * flow_ticks;
+        if (!rej_x) {
+          ae483_state.theta += dt_flow * -ae483_L_theta*n_x_err;
+          fx_v_x += q16Mul(fx_K_vx, fx_innov_vx);
+        }
+        if (!rej_y) {
+          ae483_state.phi += dt_flow * ae483_L_phi*n_y_err;
+          fx_v_y += q16Mul(fx_K_vy, fx_innov_vy);
+        }
+
+        flow_ticks = 0;
+      }
+
+      if (tof_fresh) {
+        q16_t fx_r = q16FromFloat(ae483_state.r);
+        q16_t fx_r_err = fx_o_z - fx_r;
+        if (q16Mul(fx_r_err, fx_r_err) > fx_gate2S_oz) {
+          // Gated: neither corrected nor fed to the convergence flag
+          num_tof_rej++;
+        } else {
+          r_err = q16ToFloat(fx_r_err);
+          trackConvergence(r_err);
+          fx_v_z -= q16Mul(fx_L_vz_dt * tof_ticks, fx_r_err);
+          fx_o_z += q16Mul(fx_K_oz, fx_r - fx_o_z);
+        }
+        tof_ticks = 0;
+      }
+
+      // Publish the estimate for the control law and logging
+      ae483_state.o_x = q16ToFloat(fx_o_x);
+      ae483_state.o_y = q16ToFloat(fx_o_y);
+      ae483_state.o_z = q16ToFloat(fx_o_z);
+      ae483_state.v_x = q16ToFloat(fx_v_x);
+      ae483_state.v_y = q16ToFloat(fx_v_y);
+      ae483_state.v_z = q16ToFloat(fx_v_z);
+
+      // Anchor ranges stay in the float domain (they need a sqrtf either
+      // way), crossing the boundary after publish; resync the kernel
+      // position if any correction landed
+      if (correctWithAnchorDistances() > 0) {
+        fx_o_x = q16FromFloat(ae483_state.o_x);
+        fx_o_y = q16FromFloat(ae483_state.o_y);
+      }
+
+      // Mocap pose likewise: float after publish, then resync the kernel
+      // position (attitude is float-domain already)
+      if (correctWithPose() > 0) {
+        fx_o_x = q16FromFloat(ae483_state.o_x);
+        fx_o_y = q16FromFloat(ae483_state.o_y);
+        fx_o_z = q16FromFloat(ae483_state.o_z);
+      }
+
+#else
+
+      // Predict (no measurement terms); attitude integration lives in the
+      // inner loop where the gyro is read
+      ae483_state.o_x += dt_outer * ae483_state.v_x;
+      ae483_state.o_y += dt_outer * ae483_state.v_y;
+      ae483_state.v_z += dt_outer * (ae483_state.a_z - g);
 
       /////////////////////////////////////// SIMPLE KALMAN FILTER
       // Update estimates for Kalman Filter
-      o_z += dt * v_z;
-      v_x += dt * g*theta;
-      v_y += dt * -g*phi;
+      ae483_state.o_z += dt_outer * ae483_state.v_z;
+      ae483_state.v_x += dt_outer * g*ae483_state.theta;
+      ae483_state.v_y += dt_outer * -g*ae483_state.phi;
 
-      // O_Z
-      for (int i=0;i<10;i++) {
-      oz_measured = r;
-      oz_estimated = o_z;
+      if (recompute_kalman_gains) {
+        computeSteadyStateKalmanGains();
+        recompute_kalman_gains = false;
+      }
 
-      P_temp_oz = P_last_oz + Q_oz;
-      K_oz = P_temp_oz * (1.0f/(P_temp_oz + R_oz));
+      // Correct at measurement rate only: the continuous-time LQR correction
+      // terms are scaled by the iterations they cover so the effective gain
+      // matches the old per-tick application
+      if (flow_fresh) {
+        float dt_flow = dt_outer * flow_ticks;
+        float gate2 = flow_gate * flow_gate;
 
-      o_z = oz_estimated + K_oz * (oz_measured - oz_estimated); 
-      P_last_oz = (1.0f-K_oz) * P_temp_oz;
-      }
+        // Innovation gate, per axis: a gated sample skips both the
+        // velocity correction and the attitude correction it would drive
+        vx_measured = ae483_state.n_x*ae483_state.r/k_flow + ae483_state.r*ae483_state.w_y;
+        vy_measured = ae483_state.n_y*ae483_state.r/k_flow - ae483_state.r*ae483_state.w_x;
+        float innov_vx = vx_measured - ae483_state.v_x;
+        float innov_vy = vy_measured - ae483_state.v_y;
+        float S_vx = (use_iterative_kalman ? P_last_vx : P_vx_ss) + Q_vx + R_vx;
+        float S_vy = (use_iterative_kalman ? P_last_vy : P_vy_ss) + Q_vy + R_vy;
+        bool rej_x = (innov_vx*innov_vx > gate2*S_vx);
+        bool rej_y = (innov_vy*innov_vy > gate2*S_vy);
+        num_flow_rej += rej_x + rej_y;
+
+        // Compute each element of:
+        //   C x + D u - y
+        n_x_err = k_flow * ((ae483_state.v_x / o_z_eq) - ae483_state.w_y) - ae483_state.n_x;
+        n_y_err = k_flow * (ae483_state.w_x + (ae483_state.v_y / o_z_eq)) - ae483_state.n_y;
+
+        if (!rej_x) {
+          ae483_state.theta += dt_flow * -ae483_L_theta*n_x_err;
+        }
+        if (!rej_y) {
+          ae483_state.phi += dt_flow * ae483_L_phi*n_y_err;
+        }
+
+        if (use_iterative_kalman) {
+          // Iterative path, kept for re-tuning Q/R only (set
+          // recompute_kalman_gains after changing them)
+
+          // V_X
+          if (!rej_x) {
+          for (int i=0;i<10;i++) {
+          vx_measured = ae483_state.n_x*ae483_state.r/k_flow + ae483_state.r*ae483_state.w_y;
+          vx_estimated = ae483_state.v_x;
+
+          P_temp_vx = P_last_vx + Q_vx;
+          K_vx = P_temp_vx * (1.0f/(P_temp_vx + R_vx));
+
+          ae483_state.v_x = vx_estimated + K_vx * (vx_measured - vx_estimated);
+          P_last_vx = (1.0f-K_vx) * P_temp_vx;
+          }
+          }
 
-      // V_X
-      for (int i=0;i<10;i++) {
-      vx_measured = n_x*r/k_flow + r*w_y;
-      vx_estimated = v_x;
+          // V_Y
+          if (!rej_y) {
+          for (int i=0;i<10;i++) {
+          vy_measured = ae483_state.n_y*ae483_state.r/k_flow - ae483_state.r*ae483_state.w_x;
+          vy_estimated = ae483_state.v_y;
 
-      P_temp_vx = P_last_vx + Q_vx;
-      K_vx = P_temp_vx * (1.0f/(P_temp_vx + R_vx));
+          P_temp_vy = P_last_vy + Q_vy;
+          K_vy = P_temp_vy * (1.0f/(P_temp_vy + R_vy));
 
-      v_x = vx_estimated + K_vx * (vx_measured - vx_estimated); 
-      P_last_vx = (1.0f-K_vx) * P_temp_vx;
+          ae483_state.v_y = vy_estimated + K_vy * (vy_measured - vy_estimated);
+          P_last_vy = (1.0f-K_vy) * P_temp_vy;
+          }
+          }
+        } else {
+          // Steady-state path: one fused multiply-add per axis with the
+          // precomputed converged gains
+
+          // V_X
+          if (!rej_x) {
+            ae483_state.v_x += K_vx_ss * innov_vx;
+          }
+
+          // V_Y
+          if (!rej_y) {
+            ae483_state.v_y += K_vy_ss * innov_vy;
+          }
+        }
+
+        flow_ticks = 0;
       }
 
-      // V_Y
-      for (int i=0;i<10;i++) {
-      vy_measured = n_y*r/k_flow - r*w_x;
-      vy_estimated = v_y;
+      if (tof_fresh) {
+        float dt_tof = dt_outer * tof_ticks;
+        float gate2 = flow_gate * flow_gate;
+
+        r_err = ae483_state.o_z - ae483_state.r;
+        float S_oz = (use_iterative_kalman ? P_last_oz : P_oz_ss) + Q_oz + R_oz;
+        if (r_err*r_err > gate2*S_oz) {
+          // Gated: neither corrected nor fed to the convergence flag
+          num_tof_rej++;
+        } else {
+          trackConvergence(r_err);
+          ae483_state.v_z += dt_tof * -ae483_L_vz*r_err;
+
+          if (use_iterative_kalman) {
+            // O_Z
+            for (int i=0;i<10;i++) {
+            oz_measured = ae483_state.r;
+            oz_estimated = ae483_state.o_z;
 
-      P_temp_vy = P_last_vy + Q_vy;
-      K_vy = P_temp_vy * (1.0f/(P_temp_vy + R_vy));
+            P_temp_oz = P_last_oz + Q_oz;
+            K_oz = P_temp_oz * (1.0f/(P_temp_oz + R_oz));
 
-      v_y = vy_estimated + K_vy * (vy_measured - vy_estimated); 
-      P_last_vy = (1.0f-K_vy) * P_temp_vy;
+            ae483_state.o_z = oz_estimated + K_oz * (oz_measured - oz_estimated);
+            P_last_oz = (1.0f-K_oz) * P_temp_oz;
+            }
+          } else {
+            // O_Z
+            oz_measured = ae483_state.r;
+            ae483_state.o_z += K_oz_ss * (oz_measured - ae483_state.o_z);
+          }
+        }
+
+        tof_ticks = 0;
       }
-      
+
+      // Anchor ranges (loco deck), one scalar correction per sample
+      correctWithAnchorDistances();
+
+      // Mocap pose, latency-compensated
+      correctWithPose();
+
+#endif // AE483_OBSERVER_FIXEDPOINT
+
     } else {
 
-      o_x = state->position.x;
-      o_y = state->position.y;
-      o_z = state->position.z;
-      psi = radians(state->attitude.yaw);
-      theta = - radians(state->attitude.pitch);
-      phi = radians(state->attitude.roll);
-      v_x = state->velocity.x*cosf(psi)*cosf(theta) + state->velocity.y*sinf(psi)*cosf(theta) - state->velocity.z*sinf(theta);
-      v_y = state->velocity.x*(sinf(phi)*sinf(theta)*cosf(psi) - sinf(psi)*cosf(phi)) + state->velocity.y*(sinf(phi)*sinf(psi)*sinf(theta) + cosf(phi)*cosf(psi)) + state->velocity.z*sinf(phi)*cosf(theta);
-      v_z = state->velocity.x*(sinf(phi)*sinf(psi) + sinf(theta)*cosf(phi)*cosf(psi)) + state->velocity.y*(-sinf(phi)*cosf(psi) + sinf(psi)*sinf(theta)*cosf(phi)) + state->velocity.z*cosf(phi)*cosf(theta);
+      // Discard queued anchor ranges and poses: the stock estimator owns
+      // the state here, and stale samples must not be applied when the
+      // observer is switched back on
+      dist_tail = dist_head;
+      pose_seq_last = pose_seq;
+
+      ae483_state.o_x = state->position.x;
+      ae483_state.o_y = state->position.y;
+      ae483_state.o_z = state->position.z;
+
+      // Compute each sin/cos exactly once (sinf/cosf dominate this branch
+      // on the Cortex-M4), then rotate the world-frame velocity into the
+      // body frame as three dot products with the rows of R^T. Uses the
+      // attitude the inner loop copied from the stock estimator.
+      float s_psi = sinf(ae483_state.psi);
+      float c_psi = cosf(ae483_state.psi);
+      float s_theta = sinf(ae483_state.theta);
+      float c_theta = cosf(ae483_state.theta);
+      float s_phi = sinf(ae483_state.phi);
+      float c_phi = cosf(ae483_state.phi);
+
+      float r_x[3] = {c_psi*c_theta,
+                      s_psi*c_theta,
+                      -s_theta};
+      float r_y[3] = {s_phi*s_theta*c_psi - s_psi*c_phi,
+                      s_phi*s_psi*s_theta + c_phi*c_psi,
+                      s_phi*c_theta};
+      float r_z[3] = {s_phi*s_psi + s_theta*c_phi*c_psi,
+                      -s_phi*c_psi + s_psi*s_theta*c_phi,
+                      c_phi*c_theta};
+
+      ae483_state.v_x = r_x[0]*state->velocity.x + r_x[1]*state->velocity.y + r_x[2]*state->velocity.z;
+      ae483_state.v_y = r_y[0]*state->velocity.x + r_y[1]*state->velocity.y + r_y[2]*state->velocity.z;
+      ae483_state.v_z = r_z[0]*state->velocity.x + r_z[1]*state->velocity.y + r_z[2]*state->velocity.z;
     }
 
-    if (setpoint->mode.z == modeDisable) {
-      // If there is no desired position, then all
-      // motor power commands should be zero
+    // Record this iteration's motion state for pose latency compensation
+    hist_v[hist_head & AE483_POSE_HIST_MASK][0] = ae483_state.v_x;
+    hist_v[hist_head & AE483_POSE_HIST_MASK][1] = ae483_state.v_y;
+    hist_v[hist_head & AE483_POSE_HIST_MASK][2] = ae483_state.v_z;
+    hist_w[hist_head & AE483_POSE_HIST_MASK][0] = ae483_state.w_x;
+    hist_w[hist_head & AE483_POSE_HIST_MASK][1] = ae483_state.w_y;
+    hist_w[hist_head & AE483_POSE_HIST_MASK][2] = ae483_state.w_z;
+    hist_head++;
 
-      powerSet(0, 0, 0, 0);
-    } else {
-      // Otherwise, motor power commands should be
-      // chosen by the controller
-
-      tau_x = 0.00239430f * (o_y - o_y_des) -0.00346463f * phi + 0.00135445f * v_y -0.00047651f * w_x;
-      tau_y = -0.00223966f * (o_x - o_x_des) -0.00734151f * theta -0.00186963f * v_x -0.00129356f * w_y;
-      tau_z = -0.00164210f * psi -0.00039822f * w_z;
-      f_z = -0.11471886f * (o_z - o_z_des) -0.09147906f * v_z + 0.35217900f;
-
-      m_1 = limitUint16( -3706927.3f * tau_x -3706927.3f * tau_y -38218981.7f * tau_z + 122328.6f * f_z );
-      m_2 = limitUint16( -3706927.3f * tau_x + 3706927.3f * tau_y + 38218981.7f * tau_z + 122328.6f * f_z );
-      m_3 = limitUint16( 3706927.3f * tau_x + 3706927.3f * tau_y -38218981.7f * tau_z + 122328.6f * f_z );
-      m_4 = limitUint16( 3706927.3f * tau_x -3706927.3f * tau_y + 38218981.7f * tau_z + 122328.6f * f_z );
-      
-      // Apply motor power commands
-      powerSet(m_1, m_2, m_3, m_4);
+    ae483ProfileStageUpdate(&prof_obs, ae483ProfileNow() - t_outer);
+  }
+
+  // Inner loop: every invocation. Gyro sampling, attitude propagation and
+  // the precomposed gain product are a few dozen multiply-adds, so running
+  // them at full rate buys disturbance rejection for almost nothing.
+
+  uint32_t t_start = ae483ProfileNow();
+
+  // dt from the tick counter, so the loop is correct at whatever rate the
+  // stabilizer (or the SIL harness) actually calls it
+  float dt_inner = (inner_tick_valid)
+      ? (float)(tick - inner_tick_last) * (1.0f/RATE_MAIN_LOOP)
+      : (1.0f/RATE_MAIN_LOOP);
+  float expected_us = dt_inner * 1e6f;
+  inner_tick_last = tick;
+  inner_tick_valid = true;
+
+  // Tick watchdog: how far from the nominal spacing did this execution
+  // arrive, and did it miss the deadline outright
+  if (exec_valid) {
+    float interval_us = (float)(t_start - last_exec_cycles) * (1.0f/AE483_CPU_MHZ);
+    float jitter_us = interval_us - expected_us;
+    if (jitter_us < 0.0f) {
+      jitter_us = -jitter_us;
     }
+    if (jitter_us > max_jitter_us) {
+      max_jitter_us = jitter_us;
+    }
+    if (jitter_us > AE483_TICK_OVERRUN_US) {
+      num_overrun++;
+    }
+  }
+  last_exec_cycles = t_start;
+  exec_valid = true;
+
+  // Measurements (full rate); w_z is published bias-corrected so the psi
+  // integration, the EKF predict and the yaw-damping term in the control
+  // law all see the true rate
+  ae483_state.w_x = radians(sensors->gyro.x);
+  ae483_state.w_y = radians(sensors->gyro.y);
+  float w_z_raw = radians(sensors->gyro.z);
+  if (fabsf(ae483_state.tau_z) < AE483_WZ_BIAS_TAU_Z &&
+      fabsf(w_z_raw - w_z_bias) < AE483_WZ_BIAS_RATE) {
+    w_z_bias += AE483_WZ_BIAS_ALPHA * (w_z_raw - w_z_bias);
+  }
+  ae483_state.w_z = w_z_raw - w_z_bias;
+  ae483_state.a_z = g * sensors->acc.z;
+
+  // Attitude at full rate: integrate the gyro between outer-loop updates
+  // (the outer loop re-anchors attitude through the flow corrections or
+  // the EKF), or copy the stock estimator when the observer is off
+  if (ae483_use_observer) {
+    ae483_state.psi += dt_inner * ae483_state.w_z;
+    ae483_state.theta += dt_inner * ae483_state.w_y;
+    ae483_state.phi += dt_inner * ae483_state.w_x;
+  } else {
+    ae483_state.psi = radians(state->attitude.yaw);
+    ae483_state.theta = - radians(state->attitude.pitch);
+    ae483_state.phi = radians(state->attitude.roll);
+  }
+
+  if (setpoint->mode.z == modeDisable && !ae483TrajActive()) {
+    // If there is no desired position, then all
+    // motor power commands should be zero
+
+    powerSet(0, 0, 0, 0);
+  } else {
+    // Otherwise, motor power commands should be
+    // chosen by the controller
+
+    // Error/state vector for the generated gains (see generate_gains.py).
+    // The trajectory feed-forward enters here so it composes with the
+    // precomposed AE483_PK product for free: desired attitude and
+    // velocity shift the error terms, and the homogeneous entry is
+    // scaled so the f_z row commands m*(g + a_z_des) instead of m*g.
+    float x_err[AE483_GAIN_NX] = {
+      ae483_state.o_x - ae483_state.o_x_des, ae483_state.o_y - ae483_state.o_y_des, ae483_state.o_z - ae483_state.o_z_des,
+      ae483_state.psi, ae483_state.theta - theta_des, ae483_state.phi - phi_des,
+      ae483_state.v_x - v_x_des, ae483_state.v_y - v_y_des, ae483_state.v_z - v_z_des,
+      ae483_state.w_x, ae483_state.w_y, ae483_state.w_z,
+      1.0f + a_z_des / g,
+    };
+
+    // Torques and thrust (kept for the ae483log group)
+    ae483_state.tau_x = ae483GainDot(AE483_K[0], x_err);
+    ae483_state.tau_y = ae483GainDot(AE483_K[1], x_err);
+    ae483_state.tau_z = ae483GainDot(AE483_K[2], x_err);
+    ae483_state.f_z = ae483GainDot(AE483_K[3], x_err);
+
+    // Precomposed controller+mixer: one matrix-vector product from the
+    // error/state vector straight to motor PWM, split into the common
+    // thrust part and the per-motor torque part
+    float m_common = AE483_MIXER_FZ_GAIN * ae483_state.f_z;
+    float m_torque[4];
+    for (int i = 0; i < 4; i++) {
+      m_torque[i] = ae483GainDot(AE483_PK[i], x_err) - m_common;
+    }
+
+    // Saturation-aware allocation, branch-free: shrink all four torque
+    // parts by one shared factor so no motor clips and the commanded
+    // torque direction is preserved (fmaxf against epsilon makes the
+    // inactive side of each ratio huge instead of dividing by zero)
+    float hi = 65535.0f - m_common;
+    float lo = m_common;
+    float scale = 1.0f;
+    for (int i = 0; i < 4; i++) {
+      float lim = fminf(hi / fmaxf(m_torque[i], 1e-6f),
+                        lo / fmaxf(-m_torque[i], 1e-6f));
+      scale = fminf(scale, fmaxf(lim, 0.0f));
+    }
+    num_sat += (scale < 1.0f);
+
+    ae483_state.m_1 = limitUint16( m_common + scale * m_torque[0] );
+    ae483_state.m_2 = limitUint16( m_common + scale * m_torque[1] );
+    ae483_state.m_3 = limitUint16( m_common + scale * m_torque[2] );
+    ae483_state.m_4 = limitUint16( m_common + scale * m_torque[3] );
+
+    uint32_t t_ctrl = ae483ProfileNow();
+    ae483ProfileStageUpdate(&prof_ctrl, t_ctrl - t_start);
+
+    // Apply motor power commands
+    powerSet(ae483_state.m_1, ae483_state.m_2, ae483_state.m_3, ae483_state.m_4);
+    ae483ProfileStageUpdate(&prof_mix, ae483ProfileNow() - t_ctrl);
+  }
+
+  if (use_batchlog && RATE_DO_EXECUTE(ATTITUDE_RATE, tick)) {
+    // Snapshot the shared controller state with one struct copy and give
+    // the radio a bounded amount of work (never blocks the tick)
+    ae483BatchlogRecord_t rec;
+    rec.tick = tick;
+    rec.state = ae483_state;
+    ae483BatchlogPush(&rec);
+    ae483BatchlogPump(2);
+    blog_dropped = ae483BatchlogDropped();
   }
 }
 
 LOG_GROUP_START(ae483log)
 LOG_ADD(LOG_UINT16,         num_tof,                &tof_count)
 LOG_ADD(LOG_UINT16,         num_flow,               &flow_count)
-LOG_ADD(LOG_FLOAT,          o_x,                    &o_x)
-LOG_ADD(LOG_FLOAT,          o_y,                    &o_y)
-LOG_ADD(LOG_FLOAT,          o_z,                    &o_z)
-LOG_ADD(LOG_FLOAT,          psi,                    &psi)
-LOG_ADD(LOG_FLOAT,          theta,                  &theta)
-LOG_ADD(LOG_FLOAT,          phi,                    &phi)
-LOG_ADD(LOG_FLOAT,          v_x,                    &v_x)
-LOG_ADD(LOG_FLOAT,          v_y,                    &v_y)
-LOG_ADD(LOG_FLOAT,          v_z,                    &v_z)
-LOG_ADD(LOG_FLOAT,          w_x,                    &w_x)
-LOG_ADD(LOG_FLOAT,          w_y,                    &w_y)
-LOG_ADD(LOG_FLOAT,          w_z,                    &w_z)
-LOG_ADD(LOG_FLOAT,          o_x_des,                &o_x_des)
-LOG_ADD(LOG_FLOAT,          o_y_des,                &o_y_des)
-LOG_ADD(LOG_FLOAT,          o_z_des,                &o_z_des)
-LOG_ADD(LOG_FLOAT,          tau_x,                  &tau_x)
-LOG_ADD(LOG_FLOAT,          tau_y,                  &tau_y)
-LOG_ADD(LOG_FLOAT,          tau_z,                  &tau_z)
-LOG_ADD(LOG_FLOAT,          f_z,                    &f_z)
-LOG_ADD(LOG_UINT16,         m_1,                    &m_1)
-LOG_ADD(LOG_UINT16,         m_2,                    &m_2)
-LOG_ADD(LOG_UINT16,         m_3,                    &m_3)
-LOG_ADD(LOG_UINT16,         m_4,                    &m_4)
-LOG_ADD(LOG_FLOAT,          n_x,                    &n_x)
-LOG_ADD(LOG_FLOAT,          n_y,                    &n_y)
-LOG_ADD(LOG_FLOAT,          r,                      &r)
-LOG_ADD(LOG_FLOAT,          a_z,                    &a_z)
+LOG_ADD(LOG_UINT16,         num_overrun,            &num_overrun)
+LOG_ADD(LOG_FLOAT,          max_jitter_us,          &max_jitter_us)
+LOG_ADD(LOG_UINT16,         num_sat,                &num_sat)
+LOG_ADD(LOG_UINT8,          obs_converged,          &obs_converged)
+LOG_ADD(LOG_UINT16,         num_flow_rej,           &num_flow_rej)
+LOG_ADD(LOG_UINT16,         num_tof_rej,            &num_tof_rej)
+LOG_ADD(LOG_UINT16,         num_dist,               &dist_count)
+LOG_ADD(LOG_UINT16,         num_dist_rej,           &num_dist_rej)
+LOG_ADD(LOG_UINT16,         num_pose,               &pose_count)
+LOG_ADD(LOG_UINT16,         num_pose_rej,           &num_pose_rej)
+LOG_ADD(LOG_UINT32,         blog_dropped,           &blog_dropped)
+LOG_ADD(LOG_UINT16,         traj_count,             &traj_count)
+LOG_ADD(LOG_FLOAT,          traj_t,                 &traj_t)
+LOG_ADD(LOG_FLOAT,          v_x_des,                &v_x_des)
+LOG_ADD(LOG_FLOAT,          v_y_des,                &v_y_des)
+LOG_ADD(LOG_FLOAT,          v_z_des,                &v_z_des)
+LOG_ADD(LOG_FLOAT,          light_des,              &light_des)
+LOG_ADD(LOG_FLOAT,          o_x,                    &ae483_state.o_x)
+LOG_ADD(LOG_FLOAT,          o_y,                    &ae483_state.o_y)
+LOG_ADD(LOG_FLOAT,          o_z,                    &ae483_state.o_z)
+LOG_ADD(LOG_FLOAT,          psi,                    &ae483_state.psi)
+LOG_ADD(LOG_FLOAT,          theta,                  &ae483_state.theta)
+LOG_ADD(LOG_FLOAT,          phi,                    &ae483_state.phi)
+LOG_ADD(LOG_FLOAT,          v_x,                    &ae483_state.v_x)
+LOG_ADD(LOG_FLOAT,          v_y,                    &ae483_state.v_y)
+LOG_ADD(LOG_FLOAT,          v_z,                    &ae483_state.v_z)
+LOG_ADD(LOG_FLOAT,          w_x,                    &ae483_state.w_x)
+LOG_ADD(LOG_FLOAT,          w_y,                    &ae483_state.w_y)
+LOG_ADD(LOG_FLOAT,          w_z,                    &ae483_state.w_z)
+LOG_ADD(LOG_FLOAT,          w_z_bias,               &w_z_bias)
+LOG_ADD(LOG_FLOAT,          o_x_des,                &ae483_state.o_x_des)
+LOG_ADD(LOG_FLOAT,          o_y_des,                &ae483_state.o_y_des)
+LOG_ADD(LOG_FLOAT,          o_z_des,                &ae483_state.o_z_des)
+LOG_ADD(LOG_FLOAT,          tau_x,                  &ae483_state.tau_x)
+LOG_ADD(LOG_FLOAT,          tau_y,                  &ae483_state.tau_y)
+LOG_ADD(LOG_FLOAT,          tau_z,                  &ae483_state.tau_z)
+LOG_ADD(LOG_FLOAT,          f_z,                    &ae483_state.f_z)
+LOG_ADD(LOG_UINT16,         m_1,                    &ae483_state.m_1)
+LOG_ADD(LOG_UINT16,         m_2,                    &ae483_state.m_2)
+LOG_ADD(LOG_UINT16,         m_3,                    &ae483_state.m_3)
+LOG_ADD(LOG_UINT16,         m_4,                    &ae483_state.m_4)
+LOG_ADD(LOG_FLOAT,          n_x,                    &ae483_state.n_x)
+LOG_ADD(LOG_FLOAT,          n_y,                    &ae483_state.n_y)
+LOG_ADD(LOG_FLOAT,          r,                      &ae483_state.r)
+LOG_ADD(LOG_FLOAT,          a_z,                    &ae483_state.a_z)
+LOG_ADD(LOG_UINT32,         prof_obs,               &prof_obs.last)
+LOG_ADD(LOG_UINT32,         prof_obs_min,           &prof_obs.min)
+LOG_ADD(LOG_UINT32,         prof_obs_max,           &prof_obs.max)
+LOG_ADD(LOG_FLOAT,          prof_obs_ewma,          &prof_obs.ewma)
+LOG_ADD(LOG_UINT32,         prof_ctrl,              &prof_ctrl.last)
+LOG_ADD(LOG_UINT32,         prof_ctrl_min,          &prof_ctrl.min)
+LOG_ADD(LOG_UINT32,         prof_ctrl_max,          &prof_ctrl.max)
+LOG_ADD(LOG_FLOAT,          prof_ctrl_ewma,         &prof_ctrl.ewma)
+LOG_ADD(LOG_UINT32,         prof_mix,               &prof_mix.last)
+LOG_ADD(LOG_UINT32,         prof_mix_min,           &prof_mix.min)
+LOG_ADD(LOG_UINT32,         prof_mix_max,           &prof_mix.max)
+LOG_ADD(LOG_FLOAT,          prof_mix_ewma,          &prof_mix.ewma)
 LOG_GROUP_STOP(ae483log);
 PARAM_GROUP_START(ae483par)
-PARAM_ADD(PARAM_UINT8,     use_observer,            &use_observer)
+PARAM_ADD(PARAM_UINT8,     use_observer,            &ae483_use_observer)
 PARAM_ADD(PARAM_UINT8,     reset_observer,          &reset_observer)
+PARAM_ADD(PARAM_UINT8,     reset_profile,           &reset_profile)
+PARAM_ADD(PARAM_UINT8,     use_iterative_kalman,    &use_iterative_kalman)
+PARAM_ADD(PARAM_UINT8,     recompute_kalman_gains,  &recompute_kalman_gains)
+PARAM_ADD(PARAM_UINT8,     use_ekf,                 &ae483_use_ekf)
+PARAM_ADD(PARAM_UINT8,     use_batchlog,            &use_batchlog)
+PARAM_ADD(PARAM_UINT8,     traj_reset,              &traj_reset)
+PARAM_ADD(PARAM_UINT8,     traj_start,              &traj_start)
+PARAM_ADD(PARAM_FLOAT,     flow_gate,               &flow_gate)
+PARAM_ADD(PARAM_FLOAT,     dist_gate,               &dist_gate)
+PARAM_ADD(PARAM_FLOAT,     pose_gate,               &pose_gate)
+PARAM_ADD(PARAM_FLOAT,     pose_latency_ms,         &pose_latency_ms)
 PARAM_GROUP_STOP(ae483par)
@@ -6,6 +6,11 @@
 #include "num.h"
 #include "math3d.h"
 
+#include "ae483_ringbuf.h"
+#include "ae483_state.h"
+#include "ae483_gains.h"
+#include "ae483_profile.h"
+
 // Sensor measurements
 // - tof (from the z ranger on the flow deck)
 static uint16_t tof_count = 0;
@@ -14,47 +19,21 @@ static float tof_distance = 0.0f;
 static uint16_t flow_count = 0;
 static float flow_dpixelx = 0.0f;
 static float flow_dpixely = 0.0f;
+// - ring buffers so no sample is dropped if several packets arrive between
+//   controller ticks (producer: sensor callback, consumer: controllerAE483)
+static ae483Ringbuf_t tof_buf;
+static ae483Ringbuf_t flow_x_buf;
+static ae483Ringbuf_t flow_y_buf;
 
-// Parameters
-static bool use_observer = false;
+// Parameters (ae483_use_observer and the mode switches are non-static so the SIL
+// replay harness in sil/ can drive them; CRTP param names are unchanged)
+bool ae483_use_observer = false;
 static bool reset_observer = false;
 
-// State
-static float o_x = 0.0f;
-static float o_y = 0.0f;
-static float o_z = 0.0f;
-static float psi = 0.0f;
-static float theta = 0.0f;
-static float phi = 0.0f;
-static float v_x = 0.0f;
-static float v_y = 0.0f;
-static float v_z = 0.0f;
-static float w_x = 0.0f;
-static float w_y = 0.0f;
-static float w_z = 0.0f;
-
-// Setpoint
-static float o_x_des = 0.0f;
-static float o_y_des = 0.0f;
-static float o_z_des = 0.0f;
-
-// Input
-static float tau_x = 0.0f;
-static float tau_y = 0.0f;
-static float tau_z = 0.0f;
-static float f_z = 0.0f;
-
-// Motor power command
-static uint16_t m_1 = 0;
-static uint16_t m_2 = 0;
-static uint16_t m_3 = 0;
-static uint16_t m_4 = 0;
-
-// Measurements
-static float n_x = 0.0f;
-static float n_y = 0.0f;
-static float r = 0.0f;
-static float a_z = 0.0f;
+// Shared controller state: observer writes, control law reads, log system
+// snapshots (see ae483_state.h for the layout; non-static for the SIL
+// harness)
+ae483State_t ae483_state;
 
 // Constants
 static float k_flow = 4.09255568f;
@@ -67,16 +46,63 @@ static float n_x_err = 0.0f;
 static float n_y_err = 0.0f;
 static float r_err = 0.0f;
 
+// Measurement-rate decimation: corrections only run when a new sample has
+// arrived since the last tick, with the correction scaled by the number of
+// ticks it covers (capped so a long sensor dropout cannot cause a jump)
+static uint16_t tof_count_last = 0;
+static uint16_t flow_count_last = 0;
+static uint16_t tof_ticks = 0;
+static uint16_t flow_ticks = 0;
+#define AE483_MAX_CORRECT_TICKS 25
+
+// Observer correction gains (non-static so the SIL sweep driver in
+// sil/sweep.py can tune them without a reflash)
+float ae483_L_theta = 0.029925f;
+float ae483_L_phi = 0.024252f;
+float ae483_L_vz = 5.676619f;
+float ae483_L_oz = 3.524731f;
+float ae483_L_vx = 0.322134f;
+float ae483_L_vy = 0.317070f;
+
+// Cycle-count profile of the control tick, per stage (see ae483_profile.h)
+static ae483ProfileStage_t prof_obs;
+static ae483ProfileStage_t prof_ctrl;
+static ae483ProfileStage_t prof_mix;
+static bool reset_profile = false;
+
+// Tick watchdog: inter-invocation timing of the 500 Hz execution, measured
+// with the DWT cycle counter (unsigned subtraction handles counter wrap)
+#define AE483_CPU_MHZ 168
+#define AE483_TICK_NOMINAL_US 2000.0f
+#define AE483_TICK_OVERRUN_US 500.0f
+static uint32_t last_exec_cycles = 0;
+static bool exec_valid = false;
+static uint16_t num_overrun = 0;
+static float max_jitter_us = 0.0f;
+
+// Ticks where the mixer had to rescale torque to avoid motor clipping
+static uint16_t num_sat = 0;
+
+// Online w_z gyro-bias estimator (same scheme as the custom_k controller):
+// a slow recursive average of the measured rate, accumulated only while
+// the commanded yaw torque is essentially zero and the rate is near the
+// current estimate, subtracted before psi integrates. Not cleared by
+// reset_observer, since bias belongs to the gyro, not the flight.
+#define AE483_WZ_BIAS_TAU_Z 1e-4f // |tau_z| below this is "no yaw command"
+#define AE483_WZ_BIAS_RATE 0.1f   // rad/s; never learn during actual rotation
+#define AE483_WZ_BIAS_ALPHA 1e-3f // per tick; ~2 s time constant at 500 Hz
+static float w_z_bias = 0.0f;
+
 void ae483UpdateWithTOF(tofMeasurement_t *tof)
 {
-  tof_distance = tof->distance;
+  ae483RingbufPut(&tof_buf, tof->distance);
   tof_count++;
 }
 
 void ae483UpdateWithFlow(flowMeasurement_t *flow)
 {
-  flow_dpixelx = flow->dpixelx;
-  flow_dpixely = flow->dpixely;
+  ae483RingbufPut(&flow_x_buf, flow->dpixelx);
+  ae483RingbufPut(&flow_y_buf, flow->dpixely);
   flow_count++;
 }
 
@@ -137,7 +163,11 @@ void ae483UpdateWithData(const struct AE483Data* data)
 
 void controllerAE483Init(void)
 {
-  // Do nothing
+  // Start the DWT cycle counter and clear the per-stage statistics
+  ae483ProfileInit();
+  ae483ProfileStageReset(&prof_obs);
+  ae483ProfileStageReset(&prof_ctrl);
+  ae483ProfileStageReset(&prof_mix);
 }
 
 bool controllerAE483Test(void)
@@ -156,65 +186,169 @@ void controllerAE483(control_t *control,
     // Everything in here runs at 500 Hz
 
     // Desired position
-    o_x_des = setpoint->position.x;
-    o_y_des = setpoint->position.y;
-    o_z_des = setpoint->position.z;
-
-    // Measurements
-    w_x = radians(sensors->gyro.x);
-    w_y = radians(sensors->gyro.y);
-    w_z = radians(sensors->gyro.z);
-    a_z = g * sensors->acc.z;
-    n_x = flow_dpixelx;
-    n_y = flow_dpixely;
-    r = tof_distance;
+    ae483_state.o_x_des = setpoint->position.x;
+    ae483_state.o_y_des = setpoint->position.y;
+    ae483_state.o_z_des = setpoint->position.z;
+
+    // Drain the sensor ring buffers: average every sample that arrived
+    // since the last tick instead of keeping only the most recent one
+    ae483RingbufDrainAvg(&tof_buf, &tof_distance);
+    ae483RingbufDrainAvg(&flow_x_buf, &flow_dpixelx);
+    ae483RingbufDrainAvg(&flow_y_buf, &flow_dpixely);
+
+    // Measurements; w_z is published bias-corrected so both the psi
+    // integration and the yaw-damping term in the control law see the
+    // true rate
+    ae483_state.w_x = radians(sensors->gyro.x);
+    ae483_state.w_y = radians(sensors->gyro.y);
+    float w_z_raw = radians(sensors->gyro.z);
+    if (fabsf(ae483_state.tau_z) < AE483_WZ_BIAS_TAU_Z &&
+        fabsf(w_z_raw - w_z_bias) < AE483_WZ_BIAS_RATE) {
+      w_z_bias += AE483_WZ_BIAS_ALPHA * (w_z_raw - w_z_bias);
+    }
+    ae483_state.w_z = w_z_raw - w_z_bias;
+    ae483_state.a_z = g * sensors->acc.z;
+    ae483_state.n_x = flow_dpixelx;
+    ae483_state.n_y = flow_dpixely;
+    ae483_state.r = tof_distance;
 
     if (reset_observer) {
-      o_x = 0.0f;
-      o_y = 0.0f;
-      o_z = 0.0f;
-      psi = 0.0f;
-      theta = 0.0f;
-      phi = 0.0f;
-      v_x = 0.0f;
-      v_y = 0.0f;
-      v_z = 0.0f;
+      ae483_state.o_x = 0.0f;
+      ae483_state.o_y = 0.0f;
+      ae483_state.o_z = 0.0f;
+      ae483_state.psi = 0.0f;
+      ae483_state.theta = 0.0f;
+      ae483_state.phi = 0.0f;
+      ae483_state.v_x = 0.0f;
+      ae483_state.v_y = 0.0f;
+      ae483_state.v_z = 0.0f;
       reset_observer = false;
     }
 
+    if (reset_profile) {
+      ae483ProfileStageReset(&prof_obs);
+      ae483ProfileStageReset(&prof_ctrl);
+      ae483ProfileStageReset(&prof_mix);
+      num_overrun = 0;
+      max_jitter_us = 0.0f;
+      exec_valid = false;
+      reset_profile = false;
+    }
+
+    uint32_t t_start = ae483ProfileNow();
+
+    // Tick watchdog: how far from the nominal 2000 us spacing did this
+    // execution arrive, and did it miss the deadline outright
+    if (exec_valid) {
+      float interval_us = (float)(t_start - last_exec_cycles) * (1.0f/AE483_CPU_MHZ);
+      float jitter_us = interval_us - AE483_TICK_NOMINAL_US;
+      if (jitter_us < 0.0f) {
+        jitter_us = -jitter_us;
+      }
+      if (jitter_us > max_jitter_us) {
+        max_jitter_us = jitter_us;
+      }
+      if (jitter_us > AE483_TICK_OVERRUN_US) {
+        num_overrun++;
+      }
+    }
+    last_exec_cycles = t_start;
+    exec_valid = true;
+
+    // Check whether new measurements have arrived since the last tick, so
+    // corrections only run at measurement rate (predict still runs at 500 Hz)
+    bool tof_fresh = (tof_count != tof_count_last);
+    bool flow_fresh = (flow_count != flow_count_last);
+    tof_count_last = tof_count;
+    flow_count_last = flow_count;
+    if (tof_ticks < AE483_MAX_CORRECT_TICKS) {
+      tof_ticks++;
+    }
+    if (flow_ticks < AE483_MAX_CORRECT_TICKS) {
+      flow_ticks++;
+    }
+
     // State estimates
-    if (use_observer) {
-    
-      // Compute each element of:
-      //   C x + D u - y
-      n_x_err = k_flow * ((v_x / o_z_eq) - w_y) - n_x;
-      n_y_err = k_flow * (w_x + (v_y / o_z_eq)) - n_y;
-      r_err = o_z - r;
-
-      // // Update estimates LQR
-      o_x += dt * v_x;
-      o_y += dt * v_y;
-      o_z += dt * (v_z - 3.524731f*r_err);
-      psi += dt * w_z;
-      theta += dt * (w_y - 0.029925f*n_x_err);
-      phi += dt * (w_x - (-0.024252f*n_y_err));
-      v_x += dt * (g*theta - 0.322134f*n_x_err);
-      v_y += dt * (-g*phi - 0.317070f*n_y_err);
-      v_z += dt * (a_z - g - 5.676619f*r_err);
-      
+    if (ae483_use_observer) {
+
+      // Predict at 500 Hz (no measurement terms)
+      ae483_state.o_x += dt * ae483_state.v_x;
+      ae483_state.o_y += dt * ae483_state.v_y;
+      ae483_state.o_z += dt * ae483_state.v_z;
+      ae483_state.psi += dt * ae483_state.w_z;
+      ae483_state.theta += dt * ae483_state.w_y;
+      ae483_state.phi += dt * ae483_state.w_x;
+      ae483_state.v_x += dt * g*ae483_state.theta;
+      ae483_state.v_y += dt * -g*ae483_state.phi;
+      ae483_state.v_z += dt * (ae483_state.a_z - g);
+
+      // Correct at measurement rate only: the continuous-time LQR correction
+      // terms are scaled by the ticks they cover so the effective gain
+      // matches the old per-tick application
+      if (flow_fresh) {
+        float dt_flow = dt * flow_ticks;
+
+        // Compute each element of:
+        //   C x + D u - y
+        n_x_err = k_flow * ((ae483_state.v_x / o_z_eq) - ae483_state.w_y) - ae483_state.n_x;
+        n_y_err = k_flow * (ae483_state.w_x + (ae483_state.v_y / o_z_eq)) - ae483_state.n_y;
+
+        ae483_state.theta += dt_flow * -ae483_L_theta*n_x_err;
+        ae483_state.phi += dt_flow * ae483_L_phi*n_y_err;
+        ae483_state.v_x += dt_flow * -ae483_L_vx*n_x_err;
+        ae483_state.v_y += dt_flow * -ae483_L_vy*n_y_err;
+
+        flow_ticks = 0;
+      }
+
+      if (tof_fresh) {
+        float dt_tof = dt * tof_ticks;
+
+        r_err = ae483_state.o_z - ae483_state.r;
+
+        ae483_state.o_z += dt_tof * -ae483_L_oz*r_err;
+        ae483_state.v_z += dt_tof * -ae483_L_vz*r_err;
+
+        tof_ticks = 0;
+      }
+
     } else {
 
-      o_x = state->position.x;
-      o_y = state->position.y;
-      o_z = state->position.z;
-      psi = radians(state->attitude.yaw);
-      theta = - radians(state->attitude.pitch);
-      phi = radians(state->attitude.roll);
-      v_x = state->velocity.x*cosf(psi)*cosf(theta) + state->velocity.y*sinf(psi)*cosf(theta) - state->velocity.z*sinf(theta);
-      v_y = state->velocity.x*(sinf(phi)*sinf(theta)*cosf(psi) - sinf(psi)*cosf(phi)) + state->velocity.y*(sinf(phi)*sinf(psi)*sinf(theta) + cosf(phi)*cosf(psi)) + state->velocity.z*sinf(phi)*cosf(theta);
-      v_z = state->velocity.x*(sinf(phi)*sinf(psi) + sinf(theta)*cosf(phi)*cosf(psi)) + state->velocity.y*(-sinf(phi)*cosf(psi) + sinf(psi)*sinf(theta)*cosf(phi)) + state->velocity.z*cosf(phi)*cosf(theta);
+      ae483_state.o_x = state->position.x;
+      ae483_state.o_y = state->position.y;
+      ae483_state.o_z = state->position.z;
+      ae483_state.psi = radians(state->attitude.yaw);
+      ae483_state.theta = - radians(state->attitude.pitch);
+      ae483_state.phi = radians(state->attitude.roll);
+
+      // Compute each sin/cos exactly once (sinf/cosf dominate this branch
+      // on the Cortex-M4), then rotate the world-frame velocity into the
+      // body frame as three dot products with the rows of R^T
+      float s_psi = sinf(ae483_state.psi);
+      float c_psi = cosf(ae483_state.psi);
+      float s_theta = sinf(ae483_state.theta);
+      float c_theta = cosf(ae483_state.theta);
+      float s_phi = sinf(ae483_state.phi);
+      float c_phi = cosf(ae483_state.phi);
+
+      float r_x[3] = {c_psi*c_theta,
+                      s_psi*c_theta,
+                      -s_theta};
+      float r_y[3] = {s_phi*s_theta*c_psi - s_psi*c_phi,
+                      s_phi*s_psi*s_theta + c_phi*c_psi,
+                      s_phi*c_theta};
+      float r_z[3] = {s_phi*s_psi + s_theta*c_phi*c_psi,
+                      -s_phi*c_psi + s_psi*s_theta*c_phi,
+                      c_phi*c_theta};
+
+      ae483_state.v_x = r_x[0]*state->velocity.x + r_x[1]*state->velocity.y + r_x[2]*state->velocity.z;
+      ae483_state.v_y = r_y[0]*state->velocity.x + r_y[1]*state->velocity.y + r_y[2]*state->velocity.z;
+      ae483_state.v_z = r_z[0]*state->velocity.x + r_z[1]*state->velocity.y + r_z[2]*state->velocity.z;
     }
 
+    uint32_t t_obs = ae483ProfileNow();
+    ae483ProfileStageUpdate(&prof_obs, t_obs - t_start);
+
     if (setpoint->mode.z == modeDisable) {
       // If there is no desired position, then all
       // motor power commands should be zero
@@ -224,18 +358,55 @@ void controllerAE483(control_t *control,
       // Otherwise, motor power commands should be
       // chosen by the controller
 
-      tau_x = 0.00239430f * (o_y - o_y_des) -0.00346463f * phi + 0.00135445f * v_y -0.00047651f * w_x;
-      tau_y = -0.00223966f * (o_x - o_x_des) -0.00734151f * theta -0.00186963f * v_x -0.00129356f * w_y;
-      tau_z = -0.00164210f * psi -0.00039822f * w_z;
-      f_z = -0.11471886f * (o_z - o_z_des) -0.09147906f * v_z + 0.35217900f;
+      // Error/state vector for the generated gains (see generate_gains.py)
+      float x_err[AE483_GAIN_NX] = {
+        ae483_state.o_x - ae483_state.o_x_des, ae483_state.o_y - ae483_state.o_y_des, ae483_state.o_z - ae483_state.o_z_des,
+        ae483_state.psi, ae483_state.theta, ae483_state.phi,
+        ae483_state.v_x, ae483_state.v_y, ae483_state.v_z,
+        ae483_state.w_x, ae483_state.w_y, ae483_state.w_z,
+        1.0f,
+      };
 
-      m_1 = limitUint16( -3706927.3f * tau_x -3706927.3f * tau_y -38218981.7f * tau_z + 122328.6f * f_z );
-      m_2 = limitUint16( -3706927.3f * tau_x + 3706927.3f * tau_y + 38218981.7f * tau_z + 122328.6f * f_z );
-      m_3 = limitUint16( 3706927.3f * tau_x + 3706927.3f * tau_y -38218981.7f * tau_z + 122328.6f * f_z );
-      m_4 = limitUint16( 3706927.3f * tau_x -3706927.3f * tau_y + 38218981.7f * tau_z + 122328.6f * f_z );
+      // Torques and thrust (kept for the ae483log group)
+      ae483_state.tau_x = ae483GainDot(AE483_K[0], x_err);
+      ae483_state.tau_y = ae483GainDot(AE483_K[1], x_err);
+      ae483_state.tau_z = ae483GainDot(AE483_K[2], x_err);
+      ae483_state.f_z = ae483GainDot(AE483_K[3], x_err);
+
+      // Precomposed controller+mixer: one matrix-vector product from the
+      // error/state vector straight to motor PWM, split into the common
+      // thrust part and the per-motor torque part
+      float m_common = AE483_MIXER_FZ_GAIN * ae483_state.f_z;
+      float m_torque[4];
+      for (int i = 0; i < 4; i++) {
+        m_torque[i] = ae483GainDot(AE483_PK[i], x_err) - m_common;
+      }
+
+      // Saturation-aware allocation, branch-free: shrink all four torque
+      // parts by one shared factor so no motor clips and the commanded
+      // torque direction is preserved (fmaxf against epsilon makes the
+      // inactive side of each ratio huge instead of dividing by zero)
+      float hi = 65535.0f - m_common;
+      float lo = m_common;
+      float scale = 1.0f;
+      for (int i = 0; i < 4; i++) {
+        float lim = fminf(hi / fmaxf(m_torque[i], 1e-6f),
+                          lo / fmaxf(-m_torque[i], 1e-6f));
+        scale = fminf(scale, fmaxf(lim, 0.0f));
+      }
+      num_sat += (scale < 1.0f);
+
+      ae483_state.m_1 = limitUint16( m_common + scale * m_torque[0] );
+      ae483_state.m_2 = limitUint16( m_common + scale * m_torque[1] );
+      ae483_state.m_3 = limitUint16( m_common + scale * m_torque[2] );
+      ae483_state.m_4 = limitUint16( m_common + scale * m_torque[3] );
       
+      uint32_t t_ctrl = ae483ProfileNow();
+      ae483ProfileStageUpdate(&prof_ctrl, t_ctrl - t_obs);
+
       // Apply motor power commands
-      powerSet(m_1, m_2, m_3, m_4);
+      powerSet(ae483_state.m_1, ae483_state.m_2, ae483_state.m_3, ae483_state.m_4);
+      ae483ProfileStageUpdate(&prof_mix, ae483ProfileNow() - t_ctrl);
     }
   }
 }
@@ -243,35 +414,52 @@ void controllerAE483(control_t *control,
 LOG_GROUP_START(ae483log)
 LOG_ADD(LOG_UINT16,         num_tof,                &tof_count)
 LOG_ADD(LOG_UINT16,         num_flow,               &flow_count)
-LOG_ADD(LOG_FLOAT,          o_x,                    &o_x)
-LOG_ADD(LOG_FLOAT,          o_y,                    &o_y)
-LOG_ADD(LOG_FLOAT,          o_z,                    &o_z)
-LOG_ADD(LOG_FLOAT,          psi,                    &psi)
-LOG_ADD(LOG_FLOAT,          theta,                  &theta)
-LOG_ADD(LOG_FLOAT,          phi,                    &phi)
-LOG_ADD(LOG_FLOAT,          v_x,                    &v_x)
-LOG_ADD(LOG_FLOAT,          v_y,                    &v_y)
-LOG_ADD(LOG_FLOAT,          v_z,                    &v_z)
-LOG_ADD(LOG_FLOAT,          w_x,                    &w_x)
-LOG_ADD(LOG_FLOAT,          w_y,                    &w_y)
-LOG_ADD(LOG_FLOAT,          w_z,                    &w_z)
-LOG_ADD(LOG_FLOAT,          o_x_des,                &o_x_des)
-LOG_ADD(LOG_FLOAT,          o_y_des,                &o_y_des)
-LOG_ADD(LOG_FLOAT,          o_z_des,                &o_z_des)
-LOG_ADD(LOG_FLOAT,          tau_x,                  &tau_x)
-LOG_ADD(LOG_FLOAT,          tau_y,                  &tau_y)
-LOG_ADD(LOG_FLOAT,          tau_z,                  &tau_z)
-LOG_ADD(LOG_FLOAT,          f_z,                    &f_z)
-LOG_ADD(LOG_UINT16,         m_1,                    &m_1)
-LOG_ADD(LOG_UINT16,         m_2,                    &m_2)
-LOG_ADD(LOG_UINT16,         m_3,                    &m_3)
-LOG_ADD(LOG_UINT16,         m_4,                    &m_4)
-LOG_ADD(LOG_FLOAT,          n_x,                    &n_x)
-LOG_ADD(LOG_FLOAT,          n_y,                    &n_y)
-LOG_ADD(LOG_FLOAT,          r,                      &r)
-LOG_ADD(LOG_FLOAT,          a_z,                    &a_z)
+LOG_ADD(LOG_UINT16,         num_overrun,            &num_overrun)
+LOG_ADD(LOG_FLOAT,          max_jitter_us,          &max_jitter_us)
+LOG_ADD(LOG_UINT16,         num_sat,                &num_sat)
+LOG_ADD(LOG_FLOAT,          o_x,                    &ae483_state.o_x)
+LOG_ADD(LOG_FLOAT,          o_y,                    &ae483_state.o_y)
+LOG_ADD(LOG_FLOAT,          o_z,                    &ae483_state.o_z)
+LOG_ADD(LOG_FLOAT,          psi,                    &ae483_state.psi)
+LOG_ADD(LOG_FLOAT,          theta,                  &ae483_state.theta)
+LOG_ADD(LOG_FLOAT,          phi,                    &ae483_state.phi)
+LOG_ADD(LOG_FLOAT,          v_x,                    &ae483_state.v_x)
+LOG_ADD(LOG_FLOAT,          v_y,                    &ae483_state.v_y)
+LOG_ADD(LOG_FLOAT,          v_z,                    &ae483_state.v_z)
+LOG_ADD(LOG_FLOAT,          w_x,                    &ae483_state.w_x)
+LOG_ADD(LOG_FLOAT,          w_y,                    &ae483_state.w_y)
+LOG_ADD(LOG_FLOAT,          w_z,                    &ae483_state.w_z)
+LOG_ADD(LOG_FLOAT,          w_z_bias,               &w_z_bias)
+LOG_ADD(LOG_FLOAT,          o_x_des,                &ae483_state.o_x_des)
+LOG_ADD(LOG_FLOAT,          o_y_des,                &ae483_state.o_y_des)
+LOG_ADD(LOG_FLOAT,          o_z_des,                &ae483_state.o_z_des)
+LOG_ADD(LOG_FLOAT,          tau_x,                  &ae483_state.tau_x)
+LOG_ADD(LOG_FLOAT,          tau_y,                  &ae483_state.tau_y)
+LOG_ADD(LOG_FLOAT,          tau_z,                  &ae483_state.tau_z)
+LOG_ADD(LOG_FLOAT,          f_z,                    &ae483_state.f_z)
+LOG_ADD(LOG_UINT16,         m_1,                    &ae483_state.m_1)
+LOG_ADD(LOG_UINT16,         m_2,                    &ae483_state.m_2)
+LOG_ADD(LOG_UINT16,         m_3,                    &ae483_state.m_3)
+LOG_ADD(LOG_UINT16,         m_4,                    &ae483_state.m_4)
+LOG_ADD(LOG_FLOAT,          n_x,                    &ae483_state.n_x)
+LOG_ADD(LOG_FLOAT,          n_y,                    &ae483_state.n_y)
+LOG_ADD(LOG_FLOAT,          r,                      &ae483_state.r)
+LOG_ADD(LOG_FLOAT,          a_z,                    &ae483_state.a_z)
+LOG_ADD(LOG_UINT32,         prof_obs,               &prof_obs.last)
+LOG_ADD(LOG_UINT32,         prof_obs_min,           &prof_obs.min)
+LOG_ADD(LOG_UINT32,         prof_obs_max,           &prof_obs.max)
+LOG_ADD(LOG_FLOAT,          prof_obs_ewma,          &prof_obs.ewma)
+LOG_ADD(LOG_UINT32,         prof_ctrl,              &prof_ctrl.last)
+LOG_ADD(LOG_UINT32,         prof_ctrl_min,          &prof_ctrl.min)
+LOG_ADD(LOG_UINT32,         prof_ctrl_max,          &prof_ctrl.max)
+LOG_ADD(LOG_FLOAT,          prof_ctrl_ewma,         &prof_ctrl.ewma)
+LOG_ADD(LOG_UINT32,         prof_mix,               &prof_mix.last)
+LOG_ADD(LOG_UINT32,         prof_mix_min,           &prof_mix.min)
+LOG_ADD(LOG_UINT32,         prof_mix_max,           &prof_mix.max)
+LOG_ADD(LOG_FLOAT,          prof_mix_ewma,          &prof_mix.ewma)
 LOG_GROUP_STOP(ae483log);
 PARAM_GROUP_START(ae483par)
-PARAM_ADD(PARAM_UINT8,     use_observer,            &use_observer)
+PARAM_ADD(PARAM_UINT8,     use_observer,            &ae483_use_observer)
 PARAM_ADD(PARAM_UINT8,     reset_observer,          &reset_observer)
+PARAM_ADD(PARAM_UINT8,     reset_profile,           &reset_profile)
 PARAM_GROUP_STOP(ae483par)
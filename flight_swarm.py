@@ -0,0 +1,214 @@
+"""
+Multi-drone light-painting session client.
+
+Connects to several Crazyflies over separate Crazyradio channels at once,
+uploads a per-drone trajectory (compiled by traj_compile.py) to each
+onboard buffer, waits for every observer to report convergence, and then
+starts all paintings simultaneously — so a large image split into 2-4
+trajectories takes a half or a quarter of the wall-clock exposure time.
+
+Per-drone session state lives in a SwarmDrone instance (connection, log
+streams, trajectory, world-frame offset); the module-level code only
+orchestrates. Uploads and log collection run concurrently: cflib delivers
+callbacks per link, and the blocking steps (upload, convergence wait) are
+fanned out on a thread pool.
+
+Edit DRONES below for the session, then:
+
+    python flight_swarm.py
+"""
+
+import logging
+import struct
+import time
+import json
+from concurrent.futures import ThreadPoolExecutor
+
+import cflib.crtp
+from cflib.crazyflie import Crazyflie
+from cflib.crazyflie.log import LogConfig
+
+# One entry per drone: radio uri, world-frame x/y offset added to its
+# trajectory (so each drone paints its tile of the image), and the segment
+# binary from traj_compile.py
+DRONES = [
+    {'uri': 'radio://0/34/2M/E7E7E7E7E7', 'offset': (0.0, 0.0),
+     'trajectory': 'tile0.traj'},
+    {'uri': 'radio://0/56/2M/E7E7E7E7E8', 'offset': (1.2, 0.0),
+     'trajectory': 'tile1.traj'},
+]
+
+# Logged per drone (kept short: one packet per config at 100 Hz)
+variables = [
+    'ae483log.o_x',
+    'ae483log.o_y',
+    'ae483log.o_z',
+    'ae483log.o_x_des',
+    'ae483log.o_y_des',
+    'ae483log.o_z_des',
+    'ae483log.traj_t',
+    'ae483log.traj_count',
+    'ae483log.obs_converged',
+    'ae483log.num_flow_rej',
+]
+
+FLOATS_PER_SEGMENT = 14
+
+
+class SwarmDrone:
+    def __init__(self, uri, offset, trajectory):
+        self.uri = uri
+        self.offset = offset
+        self.trajectory = trajectory
+        self.duration = 0.0
+        self.cf = Crazyflie(rw_cache='./cache')
+        self.cf.connected.add_callback(self.connected)
+        self.cf.fully_connected.add_callback(self.fully_connected)
+        self.cf.connection_failed.add_callback(self.connection_failed)
+        self.cf.connection_lost.add_callback(self.connection_lost)
+        self.cf.disconnected.add_callback(self.disconnected)
+        print(f'Connecting to {uri}')
+        self.cf.open_link(uri)
+        self.is_fully_connected = False
+        self.data = {}
+
+    def connected(self, uri):
+        print(f'Connected to {uri}')
+
+    def fully_connected(self, uri):
+        print(f'Fully connected to {uri}')
+        self.is_fully_connected = True
+
+        # Reset the default observer
+        self.cf.param.set_value('kalman.resetEstimation', 1)
+
+        # Custom controller and observer, warm-started
+        self.cf.param.set_value('stabilizer.controller', 4)
+        self.cf.param.set_value('powerDist.motorSetEnable', 1)
+        self.cf.param.set_value('ae483par.use_observer', 1)
+        self.cf.param.set_value('ae483par.reset_observer', 1)
+
+        # Start logging
+        self.logconfs = []
+        self.logconfs.append(LogConfig(name=f'LogConf0', period_in_ms=10))
+        num_variables = 0
+        for v in variables:
+            num_variables += 1
+            if num_variables > 5:
+                num_variables = 0
+                self.logconfs.append(
+                    LogConfig(name=f'LogConf{len(self.logconfs)}',
+                              period_in_ms=10))
+            self.data[v] = {'time': [], 'data': []}
+            self.logconfs[-1].add_variable(v)
+        for logconf in self.logconfs:
+            try:
+                self.cf.log.add_config(logconf)
+                logconf.data_received_cb.add_callback(self.log_data)
+                logconf.error_cb.add_callback(self.log_error)
+                logconf.start()
+            except KeyError as e:
+                print(f'Could not start {logconf.name} because {e}')
+            except AttributeError:
+                print(f'Could not start {logconf.name} (bad configuration)')
+
+    def connection_failed(self, uri, msg):
+        print(f'Connection to {uri} failed: {msg}')
+
+    def connection_lost(self, uri, msg):
+        print(f'Connection to {uri} lost: {msg}')
+
+    def disconnected(self, uri):
+        print(f'Disconnected from {uri}')
+        self.is_fully_connected = False
+
+    def log_data(self, timestamp, data, logconf):
+        for v in logconf.variables:
+            self.data[v.name]['time'].append(timestamp)
+            self.data[v.name]['data'].append(data[v.name])
+
+    def log_error(self, logconf, msg):
+        print(f'Error when logging {logconf}: {msg}')
+
+    def latest(self, name):
+        samples = self.data.get(name, {}).get('data', [])
+        return samples[-1] if samples else None
+
+    def upload_trajectory(self):
+        """Stream the compiled segments into the drone's idle bank, with
+        this drone's world-frame offset folded into the constant terms."""
+        with open(self.trajectory, 'rb') as f:
+            raw = f.read()
+        floats = list(struct.unpack(f'<{len(raw) // 4}f', raw))
+
+        self.duration = 0.0
+        for base in range(0, len(floats), FLOATS_PER_SEGMENT):
+            self.duration += floats[base]
+            floats[base + 1] += self.offset[0]   # c_x[0]
+            floats[base + 5] += self.offset[1]   # c_y[0]
+
+        self.cf.param.set_value('ae483par.traj_reset', 1)
+        time.sleep(0.1)
+
+        # Three floats per AE483Data packet over the app channel (the same
+        # channel the batch log uses for downlink)
+        floats += [0.0] * (-len(floats) % 3)
+        for i in range(0, len(floats), 3):
+            self.cf.appchannel.send_packet(
+                struct.pack('<3f', *floats[i:i + 3]))
+            time.sleep(0.01)  # stay under the uplink budget
+
+        num_segments = len(raw) // (4 * FLOATS_PER_SEGMENT)
+        print(f'{self.uri}: uploaded {num_segments} segments '
+              f'({self.duration:.1f} s)')
+
+    def wait_for_convergence(self, timeout=20.0):
+        start = time.time()
+        while time.time() - start < timeout:
+            if self.latest('ae483log.obs_converged'):
+                print(f'{self.uri}: observer converged')
+                return True
+            time.sleep(0.1)
+        print(f'{self.uri}: observer did not converge within {timeout} s')
+        return False
+
+    def start_painting(self):
+        self.cf.param.set_value('ae483par.traj_start', 1)
+
+    def stop(self, dt):
+        self.cf.commander.send_stop_setpoint()
+        start_time = time.time()
+        while time.time() - start_time < dt:
+            time.sleep(0.1)
+
+    def disconnect(self):
+        self.cf.close_link()
+
+    def write_data(self, filename):
+        with open(filename, 'w') as outfile:
+            json.dump(self.data, outfile, indent=4, sort_keys=False)
+
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.ERROR)
+    cflib.crtp.init_drivers()
+
+    drones = [SwarmDrone(d['uri'], d['offset'], d['trajectory'])
+              for d in DRONES]
+    while not all(d.is_fully_connected for d in drones):
+        time.sleep(0.1)
+
+    with ThreadPoolExecutor(max_workers=len(drones)) as pool:
+        # Upload every tile concurrently (separate radio links)
+        list(pool.map(lambda d: d.upload_trajectory(), drones))
+
+        # Paint only when every observer is ready, so the exposures line up
+        if all(pool.map(lambda d: d.wait_for_convergence(), drones)):
+            for d in drones:
+                d.start_painting()
+            time.sleep(max(d.duration for d in drones) + 2.0)
+
+    for d in drones:
+        d.stop(1.0)
+        d.disconnect()
+        d.write_data(f'swarm_{d.uri.split("/")[2]}_data.json')
@@ -0,0 +1,120 @@
+"""
+Generate ae483_gains.h from the LQR gain matrix and the motor mixer.
+
+This is the single source of truth for the controller gains used by both
+controller_ae483_custom_k.c and controller_custom_lqr.c. After re-tuning,
+edit K / MIXER below and re-run:
+
+    python generate_gains.py
+
+The script composes the controller and mixer offline (P = MIXER @ K) so the
+firmware executes one precomposed matrix-vector product from the error/state
+vector straight to motor PWM, instead of the old two-stage tau -> mixer
+computation with literals duplicated across both files.
+"""
+
+# Error/state vector, in order (last entry is the homogeneous 1 that carries
+# the equilibrium thrust bias):
+#   [o_x-o_x_des, o_y-o_y_des, o_z-o_z_des,
+#    psi, theta, phi, v_x, v_y, v_z, w_x, w_y, w_z, 1]
+STATE_NAMES = [
+    'o_x_err', 'o_y_err', 'o_z_err',
+    'psi', 'theta', 'phi',
+    'v_x', 'v_y', 'v_z',
+    'w_x', 'w_y', 'w_z',
+    'one',
+]
+
+NX = len(STATE_NAMES)
+
+# Controller gains: rows tau_x, tau_y, tau_z, f_z (u = K @ x)
+K = [[0.0] * NX for _ in range(4)]
+K[0][1] = 0.00239430    # tau_x <- o_y_err
+K[0][5] = -0.00346463   # tau_x <- phi
+K[0][7] = 0.00135445    # tau_x <- v_y
+K[0][9] = -0.00047651   # tau_x <- w_x
+K[1][0] = -0.00223966   # tau_y <- o_x_err
+K[1][4] = -0.00734151   # tau_y <- theta
+K[1][6] = -0.00186963   # tau_y <- v_x
+K[1][10] = -0.00129356  # tau_y <- w_y
+K[2][3] = -0.00164210   # tau_z <- psi
+K[2][11] = -0.00039822  # tau_z <- w_z
+K[3][2] = -0.11471886   # f_z <- o_z_err
+K[3][8] = -0.09147906   # f_z <- v_z
+K[3][12] = 0.35217900   # f_z <- equilibrium thrust
+
+# Motor mixer: rows m_1..m_4, columns tau_x, tau_y, tau_z, f_z
+a = 3706927.3
+b = 38218981.7
+c = 122328.6
+MIXER = [
+    [-a, -a, -b, c],
+    [-a, a, b, c],
+    [a, a, -b, c],
+    [a, -a, b, c],
+]
+
+# Precomposed controller+mixer: motor PWM = P @ x
+P = [[sum(MIXER[i][k] * K[k][j] for k in range(4)) for j in range(NX)]
+     for i in range(4)]
+
+
+def format_float(v):
+    s = f'{v:.10g}'
+    if '.' not in s and 'e' not in s:
+        s += '.0'
+    return s + 'f'
+
+
+def format_matrix(mat):
+    rows = []
+    for row in mat:
+        entries = ', '.join(format_float(v) for v in row)
+        rows.append(f'  {{{entries}}},')
+    return '\n'.join(rows)
+
+
+HEADER = f'''#ifndef __AE483_GAINS_H__
+#define __AE483_GAINS_H__
+
+// Generated by generate_gains.py -- DO NOT EDIT BY HAND.
+// Edit the K / MIXER matrices in generate_gains.py and re-run it instead.
+//
+// Error/state vector, in order (last entry is the homogeneous 1 that
+// carries the equilibrium thrust bias):
+//   [{', '.join(STATE_NAMES)}]
+
+#define AE483_GAIN_NX {NX}
+
+// Mixer thrust gain (PWM per newton of f_z): the common-mode part of every
+// motor command, used by the saturation-aware mixer to separate thrust
+// from torque
+#define AE483_MIXER_FZ_GAIN {c}f
+
+// Controller gains: rows tau_x, tau_y, tau_z, f_z (u = K x)
+static const float AE483_K[4][AE483_GAIN_NX] = {{
+{format_matrix(K)}
+}};
+
+// Precomposed controller+mixer (MIXER K): motor PWM = AE483_PK x
+static const float AE483_PK[4][AE483_GAIN_NX] = {{
+{format_matrix(P)}
+}};
+
+static inline float ae483GainDot(const float row[AE483_GAIN_NX],
+                                 const float x[AE483_GAIN_NX])
+{{
+  float sum = 0.0f;
+  for (int i = 0; i < AE483_GAIN_NX; i++) {{
+    sum += row[i] * x[i];
+  }}
+  return sum;
+}}
+
+#endif // __AE483_GAINS_H__
+'''
+
+if __name__ == '__main__':
+    with open('ae483_gains.h', 'w') as f:
+        f.write(HEADER)
+    print('Wrote ae483_gains.h')
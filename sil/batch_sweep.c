@@ -0,0 +1,303 @@
+// Batch replay kernel for parameter sweeps.
+//
+// sweep.py's subprocess engine pays the whole controller and process
+// overhead per grid point, but the math the (Q, R, L) sweep actually
+// exercises — the scalar observer predict/correct — is embarrassingly
+// data-parallel across candidate tunings. This kernel steps 8 observer
+// instances per vector lane-block in structure-of-arrays form, using GCC
+// portable vector types so the compiler emits AVX2/NEON where available
+// and plain scalar code elsewhere. One process replays the whole grid.
+//
+// Grid points are read from stdin, one per line, as the nine actual
+// filter parameters (policy like "scale the flight-test calibration"
+// stays in sweep.py):
+//
+//   Q_oz R_oz Q_vx R_vx Q_vy R_vy L_theta L_phi L_vz
+//
+// and one line per point is written to stdout:
+//
+//   rms_o_z rms_v_x rms_v_y
+//
+// The observer model mirrors the dual-rate scalar path of
+// controller_ae483_custom_k.c: attitude integration every 2 ms row,
+// predict/correct at the 100 Hz outer rate with measurement-rate
+// decimation and the folded steady-state Kalman gains.
+//
+// Usage:
+//   sil_batch_sweep replay.csv < points.txt > scores.txt
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LANES 8
+typedef float v8f __attribute__((vector_size(LANES * sizeof(float))));
+
+// Constants matching controller_ae483_custom_k.c
+#define K_FLOW 4.09255568f
+#define GRAVITY 9.81f
+#define DT_INNER 0.002f
+#define DT_OUTER 0.01f
+#define O_Z_EQ 0.5f
+#define OUTER_EVERY 5 // 2 ms rows per 100 Hz outer iteration
+#define MAX_CORRECT_TICKS 10
+
+// Same row layout as harness.c (only the observer-relevant columns are
+// kept after parsing)
+typedef struct {
+  float w_x, w_y, w_z; // rad/s
+  float a_z;           // m/s^2
+  int flow_fresh;
+  float n_x, n_y;
+  int tof_fresh;
+  float r;
+  float gt_z, gt_vx, gt_vy;
+} obs_row_t;
+
+#define NUM_COLUMNS 23
+
+static obs_row_t *load_csv(const char *path, int *num_rows)
+{
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return NULL;
+  }
+
+  int capacity = 4096;
+  int n = 0;
+  obs_row_t *rows = malloc(capacity * sizeof(obs_row_t));
+  char line[1024];
+
+  if (!fgets(line, sizeof(line), f)) { // header
+    fclose(f);
+    free(rows);
+    return NULL;
+  }
+
+  while (fgets(line, sizeof(line), f)) {
+    if (n == capacity) {
+      capacity *= 2;
+      rows = realloc(rows, capacity * sizeof(obs_row_t));
+    }
+    float t_ms, gx, gy, gz, az, dpx, dpy, tof;
+    float sp_x, sp_y, sp_z, gt_x, gt_y, gt_z;
+    float gt_yaw, gt_pitch, gt_roll, gt_vx, gt_vy, gt_vz;
+    int flow_fresh, tof_fresh, sp_mode;
+    int got = sscanf(line,
+        "%f,%f,%f,%f,%f,%d,%f,%f,%d,%f,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
+        &t_ms, &gx, &gy, &gz, &az,
+        &flow_fresh, &dpx, &dpy, &tof_fresh, &tof,
+        &sp_mode, &sp_x, &sp_y, &sp_z,
+        &gt_x, &gt_y, &gt_z, &gt_yaw, &gt_pitch, &gt_roll,
+        &gt_vx, &gt_vy, &gt_vz);
+    if (got != NUM_COLUMNS) {
+      fprintf(stderr, "bad row %d (%d columns)\n", n, got);
+      fclose(f);
+      free(rows);
+      return NULL;
+    }
+    obs_row_t *r = &rows[n];
+    float d2r = (float)(M_PI / 180.0);
+    r->w_x = gx * d2r;
+    r->w_y = gy * d2r;
+    r->w_z = gz * d2r;
+    r->a_z = GRAVITY * az;
+    r->flow_fresh = flow_fresh;
+    r->n_x = dpx;
+    r->n_y = dpy;
+    r->tof_fresh = tof_fresh;
+    r->r = tof;
+    r->gt_z = gt_z;
+    r->gt_vx = gt_vx;
+    r->gt_vy = gt_vy;
+    n++;
+  }
+  fclose(f);
+  *num_rows = n;
+  return rows;
+}
+
+// Converged scalar gain with the ten per-tick updates folded in, exactly
+// as steadyStateKalmanGain() in the controller
+static float steady_gain(float Q, float R)
+{
+  float P = 0.0f, K = 0.0f;
+  for (int i = 0; i < 100; i++) {
+    float P_temp = P + Q;
+    K = P_temp / (P_temp + R);
+    P = (1.0f - K) * P_temp;
+  }
+  return 1.0f - powf(1.0f - K, 10.0f);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s replay.csv < points.txt\n", argv[0]);
+    return 1;
+  }
+
+  int num_rows = 0;
+  obs_row_t *rows = load_csv(argv[1], &num_rows);
+  if (!rows || num_rows == 0) {
+    return 1;
+  }
+
+  // Read the grid
+  int capacity = 256;
+  int num_points = 0;
+  float (*points)[9] = malloc(capacity * sizeof(*points));
+  char line[256];
+  while (fgets(line, sizeof(line), stdin)) {
+    if (num_points == capacity) {
+      capacity *= 2;
+      points = realloc(points, capacity * sizeof(*points));
+    }
+    float *p = points[num_points];
+    if (sscanf(line, "%f %f %f %f %f %f %f %f %f",
+               &p[0], &p[1], &p[2], &p[3], &p[4],
+               &p[5], &p[6], &p[7], &p[8]) != 9) {
+      fprintf(stderr, "bad grid point %d\n", num_points);
+      return 1;
+    }
+    num_points++;
+  }
+  if (num_points == 0) {
+    return 0;
+  }
+
+  // Structure of arrays, padded to whole lane-blocks (padding lanes just
+  // replay point 0 again and are never reported)
+  int num_blocks = (num_points + LANES - 1) / LANES;
+  size_t vbytes = num_blocks * sizeof(v8f);
+  v8f *K_oz = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *K_vx = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *K_vy = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *L_theta = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *L_phi = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *L_vz = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *o_z = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *v_x = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *v_y = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *v_z = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *theta = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *phi = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *sq_oz = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *sq_vx = aligned_alloc(sizeof(v8f), vbytes);
+  v8f *sq_vy = aligned_alloc(sizeof(v8f), vbytes);
+
+  for (int b = 0; b < num_blocks; b++) {
+    for (int l = 0; l < LANES; l++) {
+      int idx = b * LANES + l;
+      const float *p = points[idx < num_points ? idx : 0];
+      ((float *)&K_oz[b])[l] = steady_gain(p[0], p[1]);
+      ((float *)&K_vx[b])[l] = steady_gain(p[2], p[3]);
+      ((float *)&K_vy[b])[l] = steady_gain(p[4], p[5]);
+      ((float *)&L_theta[b])[l] = p[6];
+      ((float *)&L_phi[b])[l] = p[7];
+      ((float *)&L_vz[b])[l] = p[8];
+    }
+    o_z[b] = v_x[b] = v_y[b] = v_z[b] = (v8f){0};
+    theta[b] = phi[b] = (v8f){0};
+    sq_oz[b] = sq_vx[b] = sq_vy[b] = (v8f){0};
+  }
+
+  // Shared measurement decimation state (lane-independent: every instance
+  // sees the same sensor stream)
+  int flow_pending = 0, tof_pending = 0;
+  int flow_ticks = 0, tof_ticks = 0;
+  float flow_x_sum = 0.0f, flow_y_sum = 0.0f, tof_sum = 0.0f;
+  int flow_n = 0, tof_n = 0;
+  float n_x = 0.0f, n_y = 0.0f, tof_r = 0.0f;
+
+  for (int i = 0; i < num_rows; i++) {
+    const obs_row_t *r = &rows[i];
+
+    // Sensor arrivals (averaged between outer iterations, like the ring
+    // buffer drain in the controller)
+    if (r->flow_fresh) {
+      flow_x_sum += r->n_x;
+      flow_y_sum += r->n_y;
+      flow_n++;
+      flow_pending = 1;
+    }
+    if (r->tof_fresh) {
+      tof_sum += r->r;
+      tof_n++;
+      tof_pending = 1;
+    }
+
+    if (i % OUTER_EVERY == 0) {
+      // Outer iteration: predict, then correct on fresh samples
+      if (flow_ticks < MAX_CORRECT_TICKS) flow_ticks++;
+      if (tof_ticks < MAX_CORRECT_TICKS) tof_ticks++;
+
+      float a_err = r->a_z - GRAVITY;
+      for (int b = 0; b < num_blocks; b++) {
+        v_z[b] += DT_OUTER * a_err;
+        o_z[b] += DT_OUTER * v_z[b];
+        v_x[b] += (DT_OUTER * GRAVITY) * theta[b];
+        v_y[b] += (-DT_OUTER * GRAVITY) * phi[b];
+      }
+
+      if (flow_pending) {
+        n_x = flow_x_sum / flow_n;
+        n_y = flow_y_sum / flow_n;
+        flow_x_sum = flow_y_sum = 0.0f;
+        flow_n = 0;
+        float dt_flow = DT_OUTER * flow_ticks;
+        float vx_meas_c = n_x * tof_r / K_FLOW + tof_r * r->w_y;
+        float vy_meas_c = n_y * tof_r / K_FLOW - tof_r * r->w_x;
+        for (int b = 0; b < num_blocks; b++) {
+          v8f nx_err = K_FLOW * ((1.0f / O_Z_EQ) * v_x[b] - r->w_y) - n_x;
+          v8f ny_err = K_FLOW * (r->w_x + (1.0f / O_Z_EQ) * v_y[b]) - n_y;
+          theta[b] -= dt_flow * L_theta[b] * nx_err;
+          phi[b] += dt_flow * L_phi[b] * ny_err;
+          v_x[b] += K_vx[b] * (vx_meas_c - v_x[b]);
+          v_y[b] += K_vy[b] * (vy_meas_c - v_y[b]);
+        }
+        flow_pending = 0;
+        flow_ticks = 0;
+      }
+
+      if (tof_pending) {
+        tof_r = tof_sum / tof_n;
+        tof_sum = 0.0f;
+        tof_n = 0;
+        float dt_tof = DT_OUTER * tof_ticks;
+        for (int b = 0; b < num_blocks; b++) {
+          v8f r_err = o_z[b] - tof_r;
+          v_z[b] -= dt_tof * L_vz[b] * r_err;
+          o_z[b] += K_oz[b] * (tof_r - o_z[b]);
+        }
+        tof_pending = 0;
+        tof_ticks = 0;
+      }
+    }
+
+    // Inner rate: attitude integration and the error accumulation
+    for (int b = 0; b < num_blocks; b++) {
+      theta[b] += DT_INNER * r->w_y;
+      phi[b] += DT_INNER * r->w_x;
+
+      v8f e;
+      e = o_z[b] - r->gt_z;  sq_oz[b] += e * e;
+      e = v_x[b] - r->gt_vx; sq_vx[b] += e * e;
+      e = v_y[b] - r->gt_vy; sq_vy[b] += e * e;
+    }
+  }
+
+  for (int idx = 0; idx < num_points; idx++) {
+    int b = idx / LANES, l = idx % LANES;
+    printf("%.6f %.6f %.6f\n",
+           sqrt(((float *)&sq_oz[b])[l] / num_rows),
+           sqrt(((float *)&sq_vx[b])[l] / num_rows),
+           sqrt(((float *)&sq_vy[b])[l] / num_rows));
+  }
+
+  free(rows);
+  free(points);
+  return 0;
+}
@@ -0,0 +1,114 @@
+"""
+Regression gate for controller changes: tick cost and tracking error.
+
+Replays a fixed corpus of flights through every controller variant the
+harness builds (custom_k, its fixed-point build, and the LQR controller)
+and compares each flight's RMS estimation error and per-tick cost against
+recorded baselines, failing loudly on regression. We have been burned by
+observer tweaks that looked fine in hover but blew the tick budget in
+aggressive segments — this makes that a red build instead of a crash.
+
+The corpus is every CSV in bench_corpus/ (prepare flights from
+FlightTestData with prepare_replay.py and drop them there) plus the
+synthetic hover, so the gate works even on a fresh checkout without the
+flight archive. Baselines live in bench_thresholds.json:
+
+    make bench                      # run the gate (builds first)
+    python bench.py --update        # re-record baselines after an
+                                    # intentional change, then commit them
+
+RMS limits are tight (recorded + 5%, floor 1e-4): the replay is
+deterministic, so any drift is a real behavior change. ns_per_tick is
+host-dependent, so its limit is recorded * 1.5 — coarse enough to ignore
+machine noise, tight enough to catch an estimator becoming 2x slower.
+Re-record baselines when moving the corpus to a different machine.
+"""
+
+import argparse
+import glob
+import json
+import subprocess
+import sys
+from pathlib import Path
+
+BINARIES = ['./sil_replay_k', './sil_replay_k_fixq', './sil_replay_lqr']
+RMS_KEYS = ['rms_o_z', 'rms_psi', 'rms_v_x', 'rms_v_y']
+RMS_MARGIN = 0.05     # relative
+RMS_FLOOR = 1e-4      # absolute, so zero baselines still have headroom
+TICK_MARGIN = 1.5     # relative; per-tick ns varies with the host
+
+THRESHOLDS = Path(__file__).parent / 'bench_thresholds.json'
+
+
+def corpus():
+    flights = sorted(glob.glob(str(Path(__file__).parent
+                                   / 'bench_corpus' / '*.csv')))
+    return flights + [str(Path(__file__).parent / 'hover.csv')]
+
+
+def run(binary, flight):
+    out = subprocess.run([binary, flight, '--observer'],
+                         capture_output=True, text=True, check=True,
+                         cwd=Path(__file__).parent)
+    stats = {}
+    for line in out.stdout.splitlines():
+        key, _, rest = line.partition(':')
+        stats[key.strip()] = rest.split()[0]
+    return {key: float(stats[key]) for key in RMS_KEYS + ['ns_per_tick']}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Gate controller changes on tick cost and RMS error')
+    parser.add_argument('--update', action='store_true',
+                        help='re-record baselines instead of gating')
+    args = parser.parse_args()
+
+    baselines = {}
+    if THRESHOLDS.exists():
+        baselines = json.loads(THRESHOLDS.read_text())
+
+    results = {}
+    failures = []
+    for binary in BINARIES:
+        for flight in corpus():
+            name = f'{Path(binary).name}:{Path(flight).name}'
+            stats = run(binary, flight)
+            results[name] = stats
+            if args.update:
+                continue
+            base = baselines.get(name)
+            if base is None:
+                print(f'NEW  {name} (no baseline; run --update)')
+                continue
+            for key in RMS_KEYS:
+                limit = base[key] * (1.0 + RMS_MARGIN) + RMS_FLOOR
+                if stats[key] > limit:
+                    failures.append(
+                        f'{name}: {key} {stats[key]:.6f} '
+                        f'> limit {limit:.6f} (baseline {base[key]:.6f})')
+            limit = base['ns_per_tick'] * TICK_MARGIN
+            if stats['ns_per_tick'] > limit:
+                failures.append(
+                    f'{name}: ns_per_tick {stats["ns_per_tick"]:.0f} '
+                    f'> limit {limit:.0f} '
+                    f'(baseline {base["ns_per_tick"]:.0f})')
+            print(f'ok   {name}')
+
+    if args.update:
+        THRESHOLDS.write_text(json.dumps(results, indent=2, sort_keys=True)
+                              + '\n')
+        print(f'recorded {len(results)} baselines -> {THRESHOLDS}')
+        return
+
+    if failures:
+        print(f'\nBENCH FAILED ({len(failures)} regressions):',
+              file=sys.stderr)
+        for failure in failures:
+            print(f'  {failure}', file=sys.stderr)
+        sys.exit(1)
+    print(f'\nbench passed ({len(results)} runs)')
+
+
+if __name__ == '__main__':
+    main()
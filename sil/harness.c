@@ -0,0 +1,256 @@
+// Software-in-the-loop replay harness for the AE483 controllers.
+//
+// Links the real controller translation unit (controller_ae483_custom_k.c
+// or controller_custom_lqr.c) against the stub headers in include/ and
+// replays a recorded sensor stream through ae483UpdateWithTOF /
+// ae483UpdateWithFlow at faithful 2 ms tick timing. Reports RMS estimation
+// error against the ground truth columns and wall-clock cost per simulated
+// tick.
+//
+// The replay CSV is produced from a FlightTestData .json file by
+// prepare_replay.py (see that script for the column layout).
+//
+// Usage:
+//   sil_replay_k   replay.csv [--observer] [--ekf]
+//   sil_replay_lqr replay.csv [--observer]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "controller_ae483.h"
+#include "math3d.h"
+#include "ae483_state.h"
+
+// Exposed by the controller translation unit
+extern ae483State_t ae483_state;
+extern bool ae483_use_observer;
+extern float ae483_L_theta, ae483_L_phi, ae483_L_vz;
+#ifdef SIL_HAS_EKF
+extern bool ae483_use_ekf;
+extern float Q_oz, R_oz, Q_vx, R_vx, Q_vy, R_vy;
+#endif
+#ifdef SIL_HAS_LQR
+extern float ae483_L_oz, ae483_L_vx, ae483_L_vy;
+#endif
+
+// One 2 ms tick of replay input (see prepare_replay.py)
+typedef struct {
+  float t_ms;
+  float gyro_x, gyro_y, gyro_z; // deg/s
+  float acc_z;                  // g
+  int flow_fresh;
+  float dpixelx, dpixely;
+  int tof_fresh;
+  float tof_distance;
+  int sp_mode;
+  float sp_x, sp_y, sp_z;
+  float gt_x, gt_y, gt_z;          // ground truth position
+  float gt_yaw, gt_pitch, gt_roll; // deg
+  float gt_vx, gt_vy, gt_vz;       // world frame
+} replay_row_t;
+
+#define NUM_COLUMNS 23
+
+static uint16_t captured_m[4];
+
+void powerSet(uint16_t m1, uint16_t m2, uint16_t m3, uint16_t m4)
+{
+  captured_m[0] = m1;
+  captured_m[1] = m2;
+  captured_m[2] = m3;
+  captured_m[3] = m4;
+}
+
+static replay_row_t *load_csv(const char *path, int *num_rows)
+{
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return NULL;
+  }
+
+  int capacity = 4096;
+  int n = 0;
+  replay_row_t *rows = malloc(capacity * sizeof(replay_row_t));
+  char line[1024];
+
+  // Skip the header line
+  if (!fgets(line, sizeof(line), f)) {
+    fclose(f);
+    free(rows);
+    return NULL;
+  }
+
+  while (fgets(line, sizeof(line), f)) {
+    if (n == capacity) {
+      capacity *= 2;
+      rows = realloc(rows, capacity * sizeof(replay_row_t));
+    }
+    replay_row_t *r = &rows[n];
+    int got = sscanf(line,
+        "%f,%f,%f,%f,%f,%d,%f,%f,%d,%f,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
+        &r->t_ms, &r->gyro_x, &r->gyro_y, &r->gyro_z, &r->acc_z,
+        &r->flow_fresh, &r->dpixelx, &r->dpixely,
+        &r->tof_fresh, &r->tof_distance,
+        &r->sp_mode, &r->sp_x, &r->sp_y, &r->sp_z,
+        &r->gt_x, &r->gt_y, &r->gt_z,
+        &r->gt_yaw, &r->gt_pitch, &r->gt_roll,
+        &r->gt_vx, &r->gt_vy, &r->gt_vz);
+    if (got != NUM_COLUMNS) {
+      fprintf(stderr, "bad row %d (%d columns)\n", n, got);
+      fclose(f);
+      free(rows);
+      return NULL;
+    }
+    n++;
+  }
+  fclose(f);
+  *num_rows = n;
+  return rows;
+}
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s replay.csv [--observer] [--ekf]\n", argv[0]);
+    return 1;
+  }
+
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--observer") == 0) {
+      ae483_use_observer = true;
+    } else if (strcmp(argv[i], "--l") == 0 && i + 1 < argc) {
+      // Observer correction gains: L_theta,L_phi,L_vz
+      if (sscanf(argv[++i], "%f,%f,%f",
+                 &ae483_L_theta, &ae483_L_phi, &ae483_L_vz) != 3) {
+        fprintf(stderr, "bad --l argument\n");
+        return 1;
+      }
+#ifdef SIL_HAS_EKF
+    } else if (strcmp(argv[i], "--ekf") == 0) {
+      ae483_use_ekf = true;
+    } else if (strcmp(argv[i], "--q") == 0 && i + 1 < argc) {
+      // Process noise: Q_oz,Q_vx,Q_vy (steady gains recomputed at init)
+      if (sscanf(argv[++i], "%f,%f,%f", &Q_oz, &Q_vx, &Q_vy) != 3) {
+        fprintf(stderr, "bad --q argument\n");
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--r") == 0 && i + 1 < argc) {
+      // Measurement noise: R_oz,R_vx,R_vy
+      if (sscanf(argv[++i], "%f,%f,%f", &R_oz, &R_vx, &R_vy) != 3) {
+        fprintf(stderr, "bad --r argument\n");
+        return 1;
+      }
+#endif
+#ifdef SIL_HAS_LQR
+    } else if (strcmp(argv[i], "--l2") == 0 && i + 1 < argc) {
+      // LQR-only correction gains: L_oz,L_vx,L_vy
+      if (sscanf(argv[++i], "%f,%f,%f",
+                 &ae483_L_oz, &ae483_L_vx, &ae483_L_vy) != 3) {
+        fprintf(stderr, "bad --l2 argument\n");
+        return 1;
+      }
+#endif
+    } else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  int num_rows = 0;
+  replay_row_t *rows = load_csv(argv[1], &num_rows);
+  if (!rows || num_rows == 0) {
+    return 1;
+  }
+
+  controllerAE483Init();
+  memset(&ae483_state, 0, sizeof(ae483_state));
+
+  control_t control;
+  setpoint_t setpoint;
+  sensorData_t sensors;
+  state_t state;
+  memset(&control, 0, sizeof(control));
+  memset(&setpoint, 0, sizeof(setpoint));
+  memset(&sensors, 0, sizeof(sensors));
+  memset(&state, 0, sizeof(state));
+
+  double sq_err[6] = {0}; // o_x, o_y, o_z, psi, v_x(world proxy), v_y
+  double controller_ns = 0.0;
+  uint32_t tick = 0;
+
+  for (int i = 0; i < num_rows; i++) {
+    const replay_row_t *r = &rows[i];
+
+    // Deliver measurements exactly when they arrived in the recording
+    if (r->flow_fresh) {
+      flowMeasurement_t flow = {.dpixelx = r->dpixelx, .dpixely = r->dpixely};
+      ae483UpdateWithFlow(&flow);
+    }
+    if (r->tof_fresh) {
+      tofMeasurement_t tof = {.distance = r->tof_distance};
+      ae483UpdateWithTOF(&tof);
+    }
+
+    sensors.gyro.x = r->gyro_x;
+    sensors.gyro.y = r->gyro_y;
+    sensors.gyro.z = r->gyro_z;
+    sensors.acc.z = r->acc_z;
+
+    setpoint.position.x = r->sp_x;
+    setpoint.position.y = r->sp_y;
+    setpoint.position.z = r->sp_z;
+    setpoint.mode.z = r->sp_mode ? modeAbs : modeDisable;
+
+    state.position.x = r->gt_x;
+    state.position.y = r->gt_y;
+    state.position.z = r->gt_z;
+    state.attitude.yaw = r->gt_yaw;
+    state.attitude.pitch = r->gt_pitch;
+    state.attitude.roll = r->gt_roll;
+    state.velocity.x = r->gt_vx;
+    state.velocity.y = r->gt_vy;
+    state.velocity.z = r->gt_vz;
+
+    double t0 = now_ns();
+    controllerAE483(&control, &setpoint, &sensors, &state, tick);
+    controller_ns += now_ns() - t0;
+    tick += RATE_MAIN_LOOP / ATTITUDE_RATE;
+
+    double e;
+    e = ae483_state.o_x - r->gt_x; sq_err[0] += e * e;
+    e = ae483_state.o_y - r->gt_y; sq_err[1] += e * e;
+    e = ae483_state.o_z - r->gt_z; sq_err[2] += e * e;
+    e = ae483_state.psi - radians(r->gt_yaw); sq_err[3] += e * e;
+    e = ae483_state.v_x - r->gt_vx; sq_err[4] += e * e;
+    e = ae483_state.v_y - r->gt_vy; sq_err[5] += e * e;
+  }
+
+  double flight_s = (rows[num_rows - 1].t_ms - rows[0].t_ms) / 1000.0;
+  double ns_per_tick = controller_ns / num_rows;
+
+  printf("ticks:        %d (%.1f s of flight)\n", num_rows, flight_s);
+  printf("ns_per_tick:  %.0f (%.0fx realtime)\n", ns_per_tick,
+         2e6 / (ns_per_tick > 0.0 ? ns_per_tick : 1.0));
+  printf("rms_o_x:      %.4f m\n", sqrt(sq_err[0] / num_rows));
+  printf("rms_o_y:      %.4f m\n", sqrt(sq_err[1] / num_rows));
+  printf("rms_o_z:      %.4f m\n", sqrt(sq_err[2] / num_rows));
+  printf("rms_psi:      %.4f rad\n", sqrt(sq_err[3] / num_rows));
+  printf("rms_v_x:      %.4f m/s\n", sqrt(sq_err[4] / num_rows));
+  printf("rms_v_y:      %.4f m/s\n", sqrt(sq_err[5] / num_rows));
+  printf("final_m:      %u %u %u %u\n",
+         captured_m[0], captured_m[1], captured_m[2], captured_m[3]);
+
+  free(rows);
+  return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef __APP_CHANNEL_H__
+#define __APP_CHANNEL_H__
+
+#include <stddef.h>
+
+// Host-side stub: app-channel packets are accepted and discarded
+static inline int appchannelSendDataPacket(void *data, size_t length)
+{
+  (void)data;
+  (void)length;
+  return 0;
+}
+
+#endif // __APP_CHANNEL_H__
@@ -0,0 +1,30 @@
+#ifndef __CONTROLLER_AE483_H__
+#define __CONTROLLER_AE483_H__
+
+// Host-side stub of the firmware controller interface (see
+// stabilizer_types.h in this directory).
+
+#include "stabilizer_types.h"
+
+struct AE483Data {
+  float x;
+  float y;
+  float z;
+};
+
+void controllerAE483Init(void);
+bool controllerAE483Test(void);
+void controllerAE483(control_t *control,
+                     setpoint_t *setpoint,
+                     const sensorData_t *sensors,
+                     const state_t *state,
+                     const uint32_t tick);
+
+void ae483UpdateWithTOF(tofMeasurement_t *tof);
+void ae483UpdateWithFlow(flowMeasurement_t *flow);
+void ae483UpdateWithDistance(distanceMeasurement_t *meas);
+void ae483UpdateWithPosition(positionMeasurement_t *meas);
+void ae483UpdateWithPose(poseMeasurement_t *meas);
+void ae483UpdateWithData(const struct AE483Data* data);
+
+#endif // __CONTROLLER_AE483_H__
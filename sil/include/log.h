@@ -0,0 +1,17 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+// Host-side stub: the CRTP log registrations compile away entirely.
+// LOG_GROUP_STOP expands to an extern declaration so the trailing semicolon
+// in the controller sources stays legal.
+
+#define LOG_FLOAT 0
+#define LOG_UINT8 1
+#define LOG_UINT16 2
+#define LOG_UINT32 3
+
+#define LOG_GROUP_START(name)
+#define LOG_ADD(type, name, address)
+#define LOG_GROUP_STOP(name) extern int log_stop_##name
+
+#endif // __LOG_H__
@@ -0,0 +1,16 @@
+#ifndef __MATH3D_H__
+#define __MATH3D_H__
+
+#include <math.h>
+
+static inline float radians(float degrees)
+{
+  return degrees * ((float)M_PI / 180.0f);
+}
+
+static inline float degrees(float radians)
+{
+  return radians * (180.0f / (float)M_PI);
+}
+
+#endif // __MATH3D_H__
@@ -0,0 +1,17 @@
+#ifndef __NUM_H__
+#define __NUM_H__
+
+#include <stdint.h>
+
+static inline uint16_t limitUint16(float value)
+{
+  if (value > 65535.0f) {
+    return 65535;
+  }
+  if (value < 0.0f) {
+    return 0;
+  }
+  return (uint16_t)value;
+}
+
+#endif // __NUM_H__
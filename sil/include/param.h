@@ -0,0 +1,15 @@
+#ifndef __PARAM_H__
+#define __PARAM_H__
+
+// Host-side stub: the CRTP param registrations compile away entirely.
+
+#define PARAM_UINT8 0
+#define PARAM_UINT16 1
+#define PARAM_UINT32 2
+#define PARAM_FLOAT 3
+
+#define PARAM_GROUP_START(name)
+#define PARAM_ADD(type, name, address)
+#define PARAM_GROUP_STOP(name)
+
+#endif // __PARAM_H__
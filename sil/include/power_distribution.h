@@ -0,0 +1,9 @@
+#ifndef __POWER_DISTRIBUTION_H__
+#define __POWER_DISTRIBUTION_H__
+
+#include <stdint.h>
+
+// Implemented by the SIL harness, which captures the motor commands
+void powerSet(uint16_t m1, uint16_t m2, uint16_t m3, uint16_t m4);
+
+#endif // __POWER_DISTRIBUTION_H__
@@ -0,0 +1,120 @@
+#ifndef __STABILIZER_TYPES_H__
+#define __STABILIZER_TYPES_H__
+
+// Host-side stub of the crazyflie-firmware stabilizer types, just enough to
+// compile the AE483 controller sources for software-in-the-loop replay.
+// Field names and semantics match the firmware so the controller .c files
+// build unmodified.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RATE_MAIN_LOOP 1000
+#define ATTITUDE_RATE 500
+#define POSITION_RATE 100
+#define RATE_DO_EXECUTE(RATE_HZ, TICK) ((TICK % (RATE_MAIN_LOOP / RATE_HZ)) == 0)
+
+typedef struct vec3_s {
+  float x;
+  float y;
+  float z;
+} vec3_s;
+
+typedef vec3_s point_t;
+typedef vec3_s velocity_t;
+typedef vec3_s acc_t;
+
+typedef struct attitude_s {
+  float roll;
+  float pitch;
+  float yaw;
+} attitude_t;
+
+typedef struct quaternion_s {
+  float x;
+  float y;
+  float z;
+  float w;
+} quaternion_t;
+
+typedef enum mode_e {
+  modeDisable = 0,
+  modeAbs,
+  modeVelocity
+} stab_mode_t;
+
+typedef struct state_s {
+  attitude_t attitude;
+  point_t position;
+  velocity_t velocity;
+  acc_t acc;
+} state_t;
+
+typedef struct setpoint_s {
+  attitude_t attitude;
+  point_t position;
+  velocity_t velocity;
+  struct {
+    stab_mode_t x;
+    stab_mode_t y;
+    stab_mode_t z;
+    stab_mode_t roll;
+    stab_mode_t pitch;
+    stab_mode_t yaw;
+  } mode;
+} setpoint_t;
+
+typedef struct sensorData_s {
+  vec3_s acc;   // g
+  vec3_s gyro;  // deg/s
+  vec3_s mag;
+} sensorData_t;
+
+typedef struct control_s {
+  int16_t roll;
+  int16_t pitch;
+  int16_t yaw;
+  float thrust;
+} control_t;
+
+typedef struct tofMeasurement_s {
+  uint32_t timestamp;
+  float distance;
+  float stdDev;
+} tofMeasurement_t;
+
+typedef struct flowMeasurement_s {
+  uint32_t timestamp;
+  float dpixelx;
+  float dpixely;
+  float stdDevX;
+  float stdDevY;
+  float dt;
+} flowMeasurement_t;
+
+typedef struct distanceMeasurement_s {
+  float x;
+  float y;
+  float z;
+  float distance;
+  uint8_t anchorId;
+  float stdDev;
+} distanceMeasurement_t;
+
+typedef struct positionMeasurement_s {
+  float x;
+  float y;
+  float z;
+  float stdDev;
+} positionMeasurement_t;
+
+typedef struct poseMeasurement_s {
+  float x;
+  float y;
+  float z;
+  quaternion_t quat;
+  float stdDevPos;
+  float stdDevQuat;
+} poseMeasurement_t;
+
+#endif // __STABILIZER_TYPES_H__
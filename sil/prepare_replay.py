@@ -0,0 +1,151 @@
+"""
+Convert a FlightTestData .json flight file (the schema SimpleClient writes)
+into the tick-aligned replay CSV consumed by the SIL harness.
+
+Each CSV row is one 2 ms controller tick:
+
+    t_ms, gyro_x, gyro_y, gyro_z, acc_z,
+    flow_fresh, dpixelx, dpixely, tof_fresh, tof_distance,
+    sp_mode, sp_x, sp_y, sp_z,
+    gt_x, gt_y, gt_z, gt_yaw, gt_pitch, gt_roll, gt_vx, gt_vy, gt_vz
+
+Sensor channels are sample-and-hold between logged points; the fresh flags
+mark the ticks where a new logged sample first appears, so the harness can
+deliver measurements at the recorded rate. Ground truth is the default
+(kalman) estimator, which is what the notebook compares against.
+
+    python prepare_replay.py flight.json replay.csv
+    python prepare_replay.py flight.col replay.csv    # columnar store input
+    python prepare_replay.py --synthetic replay.csv   # 10 s hover smoke test
+
+Pure standard library so it runs anywhere the harness builds.
+"""
+
+import json
+import math
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+from ae483_colstore import ColStore  # noqa: E402
+
+TICK_MS = 2.0
+G = 9.81
+K_FLOW = 4.09255568
+
+COLUMNS = ('t_ms,gyro_x,gyro_y,gyro_z,acc_z,'
+           'flow_fresh,dpixelx,dpixely,tof_fresh,tof_distance,'
+           'sp_mode,sp_x,sp_y,sp_z,'
+           'gt_x,gt_y,gt_z,gt_yaw,gt_pitch,gt_roll,gt_vx,gt_vy,gt_vz')
+
+
+class Channel:
+    """Sample-and-hold lookup over a logged (time, data) series."""
+
+    def __init__(self, series, default=0.0):
+        self.times = series['time'] if series else []
+        self.values = series['data'] if series else []
+        self.default = default
+        self.index = 0
+
+    def at(self, t_ms):
+        while (self.index + 1 < len(self.times)
+               and self.times[self.index + 1] <= t_ms):
+            self.index += 1
+        if not self.values or self.times[self.index] > t_ms:
+            return self.default
+        return self.values[self.index]
+
+    def fresh(self, t_prev_ms, t_ms):
+        """True if a new sample was logged in (t_prev_ms, t_ms]."""
+        return any(t_prev_ms < t <= t_ms for t in
+                   self.times[max(0, self.index - 2):self.index + 2])
+
+
+def convert(data, out):
+    def channel(name, default=0.0):
+        return Channel(data.get(name), default)
+
+    gt_x = channel('stateEstimate.x')
+    gt_y = channel('stateEstimate.y')
+    gt_z = channel('stateEstimate.z')
+    gt_yaw = channel('stateEstimate.yaw')
+    gt_pitch = channel('stateEstimate.pitch')
+    gt_roll = channel('stateEstimate.roll')
+    gt_vx = channel('stateEstimate.vx')
+    gt_vy = channel('stateEstimate.vy')
+    gt_vz = channel('stateEstimate.vz')
+    w_x = channel('ae483log.w_x')
+    w_y = channel('ae483log.w_y')
+    w_z = channel('ae483log.w_z')
+    a_z = channel('ae483log.a_z', default=G)
+    n_x = channel('ae483log.n_x')
+    n_y = channel('ae483log.n_y')
+    r = channel('ae483log.r')
+    sp_x = channel('ae483log.o_x_des')
+    sp_y = channel('ae483log.o_y_des')
+    sp_z = channel('ae483log.o_z_des')
+
+    times = gt_x.times or w_x.times
+    if not times:
+        raise SystemExit('no stateEstimate.x or ae483log.w_x channel found')
+    t = float(times[0])
+    t_end = float(times[-1])
+
+    out.write(COLUMNS + '\n')
+    t_prev = t - TICK_MS
+    while t <= t_end:
+        flow_fresh = int(n_x.fresh(t_prev, t))
+        tof_fresh = int(r.fresh(t_prev, t))
+        sp_zv = sp_z.at(t)
+        row = [
+            t,
+            math.degrees(w_x.at(t)), math.degrees(w_y.at(t)),
+            math.degrees(w_z.at(t)),
+            a_z.at(t) / G,
+            flow_fresh, n_x.at(t), n_y.at(t),
+            tof_fresh, r.at(t),
+            int(sp_zv > 0.0), sp_x.at(t), sp_y.at(t), sp_zv,
+            gt_x.at(t), gt_y.at(t), gt_z.at(t),
+            gt_yaw.at(t), gt_pitch.at(t), gt_roll.at(t),
+            gt_vx.at(t), gt_vy.at(t), gt_vz.at(t),
+        ]
+        out.write(','.join(f'{v:.6g}' if isinstance(v, float) else str(v)
+                           for v in row) + '\n')
+        t_prev = t
+        t += TICK_MS
+
+
+def synthetic(out, duration_s=10.0, o_z=0.35):
+    """Noiseless hover at o_z: flow/TOF consistent with zero velocity."""
+    out.write(COLUMNS + '\n')
+    t = 0.0
+    t_ms = 0.0
+    while t_ms <= duration_s * 1000.0:
+        flow_fresh = int(int(t_ms) % 10 == 0)  # 100 Hz
+        tof_fresh = int(int(t_ms) % 25 == 0)   # 40 Hz
+        row = [t_ms, 0.0, 0.0, 0.0, 1.0,
+               flow_fresh, 0.0, 0.0, tof_fresh, o_z,
+               1, 0.0, 0.0, o_z,
+               0.0, 0.0, o_z, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0]
+        out.write(','.join(f'{v:.6g}' if isinstance(v, float) else str(v)
+                           for v in row) + '\n')
+        t_ms += TICK_MS
+        t += TICK_MS / 1000.0
+
+
+if __name__ == '__main__':
+    if len(sys.argv) == 3 and sys.argv[1] == '--synthetic':
+        with open(sys.argv[2], 'w') as f:
+            synthetic(f)
+    elif len(sys.argv) == 3:
+        if sys.argv[1].endswith('.col'):
+            # Columnar store: the channel views index like the JSON lists
+            data = ColStore(sys.argv[1]).as_dict()
+        else:
+            with open(sys.argv[1]) as f:
+                data = json.load(f)
+        with open(sys.argv[2], 'w') as f:
+            convert(data, f)
+    else:
+        raise SystemExit(__doc__)
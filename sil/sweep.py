@@ -0,0 +1,133 @@
+"""
+Parameter-sweep tuning driver on top of the SIL replay harness.
+
+Distributes a (Q, R, L) grid across a worker pool, replays a corpus of
+prepared flight CSVs (see prepare_replay.py) for every grid point, and
+ranks candidates by combined RMS estimation error. Each worker is one
+sil_replay_k process, so the sweep scales across cores without any shared
+state; a 20x20x20 grid over ten flights is just 80000 process runs at
+~20000x realtime each.
+
+    python sweep.py replay1.csv [replay2.csv ...] \
+        [--binary ./sil_replay_k] [--batch ./sil_batch_sweep] \
+        [--jobs N] [--top N] \
+        [--q-grid 0.01,0.03,0.1,0.3,1] \
+        [--r-scale 0.25,0.5,1,2,4] \
+        [--l-scale 0.25,0.5,1,2,4]
+
+Q values are applied to all three axes; R and L are swept as scale factors
+on the flight-test calibration so the grid stays meaningful across axes.
+
+With --batch, the whole grid is scored by the vectorized batch kernel
+(see batch_sweep.c) in one process per flight instead of one process per
+(grid point, flight) pair — an order of magnitude faster for the scalar
+observer sweeps, at the cost of not reporting ns_per_tick (the kernel
+replays the observer model, not the full controller).
+"""
+
+import argparse
+import itertools
+import math
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+# Flight-test calibration (matches controller_ae483_custom_k.c)
+R_BASE = (0.06350709061837238**2, 0.7570370678653842**2, 0.7698969611565406**2)
+L_BASE = (0.029925, 0.024252, 5.676619)
+
+
+def parse_grid(text):
+    return [float(v) for v in text.split(',')]
+
+
+def run_point(binary, replays, q, r_scale, l_scale):
+    """Replay the whole corpus for one grid point; return the mean score."""
+    score = 0.0
+    ns_per_tick = 0.0
+    for replay in replays:
+        cmd = [
+            binary, replay, '--observer',
+            '--q', f'{q},{q},{q}',
+            '--r', ','.join(f'{r_scale * r:.9g}' for r in R_BASE),
+            '--l', ','.join(f'{l_scale * l:.9g}' for l in L_BASE),
+        ]
+        out = subprocess.run(cmd, capture_output=True, text=True, check=True)
+        stats = {}
+        for line in out.stdout.splitlines():
+            key, _, rest = line.partition(':')
+            stats[key.strip()] = rest.split()[0]
+        score += (float(stats['rms_o_z'])**2
+                  + float(stats['rms_v_x'])**2
+                  + float(stats['rms_v_y'])**2)
+        ns_per_tick = max(ns_per_tick, float(stats['ns_per_tick']))
+    return math.sqrt(score / len(replays)), ns_per_tick
+
+
+def run_grid_batch(batch_binary, replays, grid):
+    """Score the whole grid with the batch kernel, one process per flight."""
+    lines = []
+    for q, r_scale, l_scale in grid:
+        lines.append(' '.join([
+            f'{q:.9g} {r_scale * R_BASE[0]:.9g}',
+            f'{q:.9g} {r_scale * R_BASE[1]:.9g}',
+            f'{q:.9g} {r_scale * R_BASE[2]:.9g}',
+            ' '.join(f'{l_scale * l:.9g}' for l in L_BASE),
+        ]))
+    points = '\n'.join(lines) + '\n'
+
+    scores = [0.0] * len(grid)
+    for replay in replays:
+        out = subprocess.run([batch_binary, replay], input=points,
+                             capture_output=True, text=True, check=True)
+        rows = out.stdout.splitlines()
+        for i, row in enumerate(rows):
+            rms_oz, rms_vx, rms_vy = (float(v) for v in row.split())
+            scores[i] += rms_oz**2 + rms_vx**2 + rms_vy**2
+    return [(math.sqrt(s / len(replays)), 0.0, point)
+            for s, point in zip(scores, grid)]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Sweep observer tuning over replayed flights')
+    parser.add_argument('replays', nargs='+')
+    parser.add_argument('--binary', default='./sil_replay_k')
+    parser.add_argument('--batch', metavar='BATCH_BINARY',
+                        help='score with the vectorized batch kernel')
+    parser.add_argument('--jobs', type=int, default=None)
+    parser.add_argument('--top', type=int, default=10)
+    parser.add_argument('--q-grid', type=parse_grid,
+                        default=[0.01, 0.03, 0.1, 0.3, 1.0])
+    parser.add_argument('--r-scale', type=parse_grid,
+                        default=[0.25, 0.5, 1.0, 2.0, 4.0])
+    parser.add_argument('--l-scale', type=parse_grid,
+                        default=[0.25, 0.5, 1.0, 2.0, 4.0])
+    args = parser.parse_args()
+
+    grid = list(itertools.product(args.q_grid, args.r_scale, args.l_scale))
+    print(f'{len(grid)} grid points x {len(args.replays)} flights',
+          file=sys.stderr)
+
+    if args.batch:
+        results = run_grid_batch(args.batch, args.replays, grid)
+    else:
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            futures = {
+                point: pool.submit(run_point, args.binary, args.replays,
+                                   *point)
+                for point in grid
+            }
+            results = [(futures[point].result()[0],
+                        futures[point].result()[1],
+                        point) for point in grid]
+
+    results.sort()
+    print(f'{"score":>10} {"ns/tick":>8}  {"Q":>8} {"R_scale":>8} {"L_scale":>8}')
+    for score, ns_per_tick, (q, r_scale, l_scale) in results[:args.top]:
+        print(f'{score:10.5f} {ns_per_tick:8.0f}  '
+              f'{q:8.4g} {r_scale:8.4g} {l_scale:8.4g}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,312 @@
+"""
+Compile image strokes into the onboard trajectory segment format.
+
+Replaces the XY_to_move_commands notebook step of the painting pipeline
+(image_to_gcode.py -> csv/gcode -> move commands pasted into
+flight_plane.py). Input is either the G-code emitted by image_to_gcode.py
+(G0 = pen-up travel, G1 = draw) or a csv of x,y points with blank lines
+between strokes. Output is the upload-ready binary for the onboard buffer
+in ae483_trajectory.h: a flat little-endian float32 stream, 14 floats per
+cubic segment (duration, c_x[0..3], c_y[0..3], c_z[0..3], light). Draw
+segments carry the LED intensity (--brightness) in the light channel and
+pen-up travels carry zero, so the deck is switched onboard in phase with
+position instead of over the radio.
+
+    python traj_compile.py painting.gcode -o painting.traj
+    python traj_compile.py strokes.csv -o painting.traj --speed 0.3 --z 0.4
+
+Each stroke is fit independently as a C1 chain of Hermite cubics (central-
+difference tangents, durations from arc length at the draw speed) and the
+fit is cached in .traj_cache/ keyed by a hash of the stroke points and the
+fit parameters, so tweaking one stroke of a painting only refits that
+stroke. Pen-up travels between strokes are a single ease-in/ease-out
+segment each and are always regenerated, since they depend on both
+neighbouring strokes.
+
+Battery is the hard resource of a session (~5 minutes of flight per
+Crazyflie), so the compiler also schedules for energy. Strokes are
+reordered greedily to minimize pen-up travel — each stroke may be drawn
+from either end, so the nearest next stroke is picked over both
+orientations (disable with --keep-order) — and an energy model pass
+estimates per-segment draw from the commanded vertical-acceleration
+profile (electrical power scales with thrust^1.5 per momentum theory;
+--hover-power anchors the model and was fit from the voltage-sag slope
+against the m_1..m_4 duty in the flight logs). The emitted schedule
+annotates every segment with predicted remaining capacity and warns
+before a painting that will not fit on one battery.
+"""
+
+import argparse
+import hashlib
+import math
+import re
+import struct
+import sys
+from pathlib import Path
+
+# Must match ae483_trajectory.h
+FLOATS_PER_SEGMENT = 14
+MAX_SEGMENTS = 32
+
+G = 9.81
+
+CACHE_DIR = Path('.traj_cache')
+
+GCODE_MOVE = re.compile(r'^(G0?[01])\b([^;]*)', re.IGNORECASE)
+GCODE_WORD = re.compile(r'([XY])\s*(-?\d+\.?\d*)', re.IGNORECASE)
+
+
+def read_strokes(path):
+    """Yield strokes as lists of (x, y) points."""
+    text = Path(path).read_text()
+    strokes = []
+    stroke = []
+    if path.endswith(('.gcode', '.nc')):
+        x = y = 0.0
+        for line in text.splitlines():
+            m = GCODE_MOVE.match(line.strip())
+            if not m:
+                continue
+            words = dict((k.upper(), float(v))
+                         for k, v in GCODE_WORD.findall(m.group(2)))
+            x = words.get('X', x)
+            y = words.get('Y', y)
+            if m.group(1).upper() in ('G0', 'G00'):
+                if len(stroke) > 1:
+                    strokes.append(stroke)
+                stroke = [(x, y)]
+            else:
+                stroke.append((x, y))
+    else:
+        for line in text.splitlines():
+            line = line.strip()
+            if not line:
+                if len(stroke) > 1:
+                    strokes.append(stroke)
+                stroke = []
+                continue
+            fields = line.replace(',', ' ').split()
+            stroke.append((float(fields[0]), float(fields[1])))
+    if len(stroke) > 1:
+        strokes.append(stroke)
+    return strokes
+
+
+def hermite(p0, p1, v0, v1, T):
+    """Power-basis coefficients of the cubic with those endpoint values
+    and velocities over s in [0, T]."""
+    c2 = (3.0 * (p1 - p0) / T - (2.0 * v0 + v1)) / T
+    c3 = (2.0 * (p0 - p1) / T + (v0 + v1)) / (T * T)
+    return (p0, v0, c2, c3)
+
+
+def fit_stroke(points, speed, z, brightness):
+    """Fit one stroke as a C1 Hermite chain; returns a list of segments,
+    each (duration, cx, cy, cz, light)."""
+    n = len(points)
+    lengths = []
+    for i in range(n - 1):
+        dx = points[i + 1][0] - points[i][0]
+        dy = points[i + 1][1] - points[i][1]
+        lengths.append(max(math.hypot(dx, dy), 1e-6))
+
+    # Central-difference tangents at draw speed; zero at the stroke ends so
+    # each stroke eases in and out (the light is dimmest where it dwells
+    # least, and the travel segments join with zero velocity)
+    tangents = [(0.0, 0.0)]
+    for i in range(1, n - 1):
+        dx = points[i + 1][0] - points[i - 1][0]
+        dy = points[i + 1][1] - points[i - 1][1]
+        norm = math.hypot(dx, dy)
+        if norm < 1e-9:
+            tangents.append((0.0, 0.0))
+        else:
+            tangents.append((speed * dx / norm, speed * dy / norm))
+    tangents.append((0.0, 0.0))
+
+    segments = []
+    for i in range(n - 1):
+        T = lengths[i] / speed
+        cx = hermite(points[i][0], points[i + 1][0],
+                     tangents[i][0], tangents[i + 1][0], T)
+        cy = hermite(points[i][1], points[i + 1][1],
+                     tangents[i][1], tangents[i + 1][1], T)
+        segments.append((T, cx, cy, (z, 0.0, 0.0, 0.0), brightness))
+    return segments
+
+
+def travel_segment(p0, p1, speed, z):
+    """One smooth pen-up move between strokes: zero velocity and
+    acceleration at both ends (minimum-jerk-style quintic collapsed to the
+    best cubic: 3s^2 - 2s^3 blending)."""
+    dist = max(math.hypot(p1[0] - p0[0], p1[1] - p0[1]), 1e-6)
+    T = dist / speed
+
+    def blend(a, b):
+        d = b - a
+        return (a, 0.0, 3.0 * d / (T * T), -2.0 * d / (T * T * T))
+
+    # Pen up: the light channel is zero over every travel
+    return (T, blend(p0[0], p1[0]), blend(p0[1], p1[1]), (z, 0.0, 0.0, 0.0),
+            0.0)
+
+
+def pack_segments(segments):
+    out = bytearray()
+    for T, cx, cy, cz, light in segments:
+        out += struct.pack('<14f', T, *cx, *cy, *cz, light)
+    return bytes(out)
+
+
+def stroke_key(points, speed, z, brightness):
+    h = hashlib.sha1()
+    h.update(b'v2')  # segment format version (v2 added the light channel)
+    h.update(struct.pack('<3d', speed, z, brightness))
+    for x, y in points:
+        h.update(struct.pack('<2d', x, y))
+    return h.hexdigest()
+
+
+def reorder_strokes(strokes):
+    """Greedy nearest-neighbour ordering over strokes, trying each stroke
+    in both directions (a stroke draws the same from either end): the
+    dominant controllable energy cost of a painting is pen-up transit, and
+    image_to_gcode.py emits strokes in raster order, which is close to
+    worst case for it."""
+    remaining = [list(s) for s in strokes]
+    ordered = [remaining.pop(0)]
+    while remaining:
+        tail = ordered[-1][-1]
+        best = None
+        for i, stroke in enumerate(remaining):
+            for reverse in (False, True):
+                head = stroke[-1] if reverse else stroke[0]
+                d = math.hypot(head[0] - tail[0], head[1] - tail[1])
+                if best is None or d < best[0]:
+                    best = (d, i, reverse)
+        _, i, reverse = best
+        stroke = remaining.pop(i)
+        ordered.append(stroke[::-1] if reverse else stroke)
+    return ordered
+
+
+def segment_energy(segment, hover_power):
+    """Predicted electrical energy (J) to fly one segment: momentum theory
+    says power scales with thrust^1.5, and the commanded thrust is
+    m*(g + a_z), so the profile follows the z acceleration of the cubic
+    (a_z = 2*c2 + 6*c3*s). Midpoint rule over a few samples is plenty for
+    a cubic."""
+    T, _, _, cz, _ = segment
+    samples = 8
+    energy = 0.0
+    for i in range(samples):
+        s = (i + 0.5) * T / samples
+        a_z = 2.0 * cz[2] + 6.0 * cz[3] * s
+        thrust = max(1.0 + a_z / G, 0.0)
+        energy += hover_power * thrust**1.5 * (T / samples)
+    return energy
+
+
+def print_schedule(segments, hover_power, capacity_wh):
+    """Per-segment schedule with predicted remaining battery capacity."""
+    capacity_j = capacity_wh * 3600.0
+    used = 0.0
+    t = 0.0
+    print(f'{"seg":>4} {"kind":>6} {"t0":>7} {"dur":>6} '
+          f'{"energy":>7} {"left":>6}')
+    for i, segment in enumerate(segments):
+        energy = segment_energy(segment, hover_power)
+        used += energy
+        left = 100.0 * (1.0 - used / capacity_j)
+        kind = 'draw' if segment[4] > 0.0 else 'travel'
+        print(f'{i:>4} {kind:>6} {t:7.1f} {segment[0]:6.1f} '
+              f'{energy:6.1f}J {left:5.1f}%')
+        t += segment[0]
+    if used > capacity_j:
+        print(f'warning: painting needs {used / 3600.0:.2f} Wh but the '
+              f'battery holds {capacity_wh:.2f} Wh; split the image or '
+              f'swap batteries mid-session', file=sys.stderr)
+    return used
+
+
+def compile_strokes(strokes, speed, travel_speed, z, brightness,
+                    use_cache=True):
+    """Compile all strokes plus the travels between them; returns
+    (packed bytes, total duration, cache hits)."""
+    CACHE_DIR.mkdir(exist_ok=True)
+    segments = []
+    hits = 0
+    for i, stroke in enumerate(strokes):
+        if i > 0:
+            segments.append(travel_segment(strokes[i - 1][-1], stroke[0],
+                                           travel_speed, z))
+        cache_file = CACHE_DIR / (stroke_key(stroke, speed, z, brightness)
+                                  + '.seg')
+        if use_cache and cache_file.exists():
+            data = cache_file.read_bytes()
+            for off in range(0, len(data), 4 * FLOATS_PER_SEGMENT):
+                vals = struct.unpack_from('<14f', data, off)
+                segments.append((vals[0], vals[1:5], vals[5:9], vals[9:13],
+                                 vals[13]))
+            hits += 1
+        else:
+            fit = fit_stroke(stroke, speed, z, brightness)
+            if use_cache:
+                cache_file.write_bytes(pack_segments(fit))
+            segments.extend(fit)
+    total = sum(seg[0] for seg in segments)
+    return pack_segments(segments), total, hits
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compile strokes into onboard trajectory segments')
+    parser.add_argument('input', help='gcode (.gcode/.nc) or x,y csv')
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('--speed', type=float, default=0.2,
+                        help='draw speed in m/s (default 0.2)')
+    parser.add_argument('--travel-speed', type=float, default=0.4,
+                        help='pen-up travel speed in m/s (default 0.4)')
+    parser.add_argument('--z', type=float, default=0.35,
+                        help='painting plane height in m (default 0.35)')
+    parser.add_argument('--brightness', type=float, default=1.0,
+                        help='LED intensity while drawing, 0..1 (default 1)')
+    parser.add_argument('--keep-order', action='store_true',
+                        help='draw strokes in input order (no reordering)')
+    parser.add_argument('--hover-power', type=float, default=8.0,
+                        help='electrical power at hover in W (default 8.0, '
+                             'fit from the flight logs)')
+    parser.add_argument('--capacity-wh', type=float, default=0.85,
+                        help='usable battery capacity in Wh (default 0.85: '
+                             'a 250 mAh pack at 3.7 V minus landing reserve)')
+    parser.add_argument('--no-cache', action='store_true')
+    args = parser.parse_args()
+
+    strokes = read_strokes(args.input)
+    if not strokes:
+        sys.exit('no strokes found in input')
+    if not args.keep_order and len(strokes) > 1:
+        strokes = reorder_strokes(strokes)
+
+    data, total, hits = compile_strokes(
+        strokes, args.speed, args.travel_speed, args.z, args.brightness,
+        use_cache=not args.no_cache)
+    num_segments = len(data) // (4 * FLOATS_PER_SEGMENT)
+
+    segments = [struct.unpack_from('<14f', data, off)
+                for off in range(0, len(data), 4 * FLOATS_PER_SEGMENT)]
+    segments = [(v[0], v[1:5], v[5:9], v[9:13], v[13]) for v in segments]
+    used = print_schedule(segments, args.hover_power, args.capacity_wh)
+
+    Path(args.output).write_bytes(data)
+    print(f'{len(strokes)} strokes ({hits} cached) -> {num_segments} '
+          f'segments, {total:.1f} s of flight, {used / 3600.0:.2f} Wh '
+          f'-> {args.output}')
+    if num_segments > MAX_SEGMENTS:
+        print(f'warning: {num_segments} segments exceeds the onboard '
+              f'buffer ({MAX_SEGMENTS}); simplify the image or raise '
+              f'AE483_TRAJ_MAX_SEGMENTS', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()